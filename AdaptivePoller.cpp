@@ -0,0 +1,161 @@
+#include "AdaptivePoller.hpp"
+
+AdaptivePoller::AdaptivePoller(TimerRegistry& registry_, Device* devices_, std::atomic<bool>* eventsPending_, uint16_t capacity_,
+								const Config& config_) :
+	mRegistry(registry_),
+	mDevices(devices_),
+	mEventsPending(eventsPending_),
+	mCapacity(capacity_),
+	mConfig(config_)
+{
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		mDevices[index] = Device{};
+		mDevices[index].mHandle = TimerRegistry::INVALID_HANDLE;
+		mEventsPending[index].store(false, std::memory_order_relaxed);
+	}
+}
+
+AdaptivePoller::~AdaptivePoller()
+{
+	for (DeviceId device = 0; device < mCapacity; ++device)
+		Remove(device);
+}
+
+AdaptivePoller::DeviceId AdaptivePoller::Add(Poll poll_, void* context_, uint32_t fastPeriodMillis_, uint32_t slowPeriodMillis_,
+												uint32_t busMicrosPerPoll_)
+{
+	if (0 == fastPeriodMillis_)
+		return INVALID_DEVICE;
+
+	for (DeviceId device = 0; device < mCapacity; ++device)
+	{
+		Device& slot = mDevices[device];
+		if (slot.mHandle != TimerRegistry::INVALID_HANDLE)
+			continue;
+
+		//	The device itself is the context, so a poll finds it in O(1).
+		const TimerRegistry::Handle handle = mRegistry.Add(OnPoll, &slot);
+		if (TimerRegistry::INVALID_HANDLE == handle)
+			return INVALID_DEVICE;
+
+		const uint64_t nowMillis = mRegistry.Now();
+		slot = Device{this, handle, poll_, context_, fastPeriodMillis_,
+						slowPeriodMillis_ > fastPeriodMillis_ ? slowPeriodMillis_ : fastPeriodMillis_,
+						fastPeriodMillis_, busMicrosPerPoll_, nowMillis, 0, 0};
+		mRegistry.ArmAt(handle, nowMillis + fastPeriodMillis_, fastPeriodMillis_);
+		return device;
+	}
+	return INVALID_DEVICE;
+}
+
+void AdaptivePoller::Remove(DeviceId device_)
+{
+	if (device_ >= mCapacity || TimerRegistry::INVALID_HANDLE == mDevices[device_].mHandle)
+		return;
+
+	mRegistry.Remove(mDevices[device_].mHandle);
+	mDevices[device_] = Device{};
+	mDevices[device_].mHandle = TimerRegistry::INVALID_HANDLE;
+	mEventsPending[device_].store(false, std::memory_order_relaxed);
+}
+
+void AdaptivePoller::NotifyEvent(DeviceId device_)
+{
+	if (device_ >= mCapacity || TimerRegistry::INVALID_HANDLE == mDevices[device_].mHandle)
+		return;
+
+	Device& device = mDevices[device_];
+	device.mPeriodMillis = device.mFastPeriodMillis;
+	mRegistry.ArmAt(device.mHandle, mRegistry.Now(), device.mPeriodMillis);
+}
+
+void AdaptivePoller::NotifyEventFromIsr(DeviceId device_)
+{
+	if (device_ >= mCapacity)
+		return;
+
+	//	Plain stores only; ProcessEvents() checks whether the device still exists.
+	mEventsPending[device_].store(true, std::memory_order_relaxed);
+	mAnyEventPending.store(true, std::memory_order_release);
+}
+
+uint16_t AdaptivePoller::ProcessEvents()
+{
+	if (!mAnyEventPending.load(std::memory_order_acquire))
+		return 0;
+
+	//	Cleared before the scan: a flag set during it is caught now or next time.
+	mAnyEventPending.store(false, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	uint16_t processed = 0;
+	for (DeviceId device = 0; device < mCapacity; ++device)
+	{
+		if (!mEventsPending[device].load(std::memory_order_relaxed))
+			continue;
+
+		mEventsPending[device].store(false, std::memory_order_relaxed);
+		if (TimerRegistry::INVALID_HANDLE == mDevices[device].mHandle)
+			continue;
+		NotifyEvent(device);
+		++processed;
+	}
+	return processed;
+}
+
+uint32_t AdaptivePoller::GetPeriod(DeviceId device_) const
+{
+	if (device_ >= mCapacity || TimerRegistry::INVALID_HANDLE == mDevices[device_].mHandle)
+		return 0;
+	return mDevices[device_].mPeriodMillis;
+}
+
+AdaptivePoller::Stats AdaptivePoller::GetStats() const
+{
+	Stats stats{};
+	const uint64_t nowMillis = mRegistry.Now();
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		const Device& device = mDevices[index];
+		if (TimerRegistry::INVALID_HANDLE == device.mHandle)
+			continue;
+
+		const uint32_t fixedRatePolls = static_cast<uint32_t>((nowMillis - device.mAddedMillis) / device.mFastPeriodMillis);
+		stats.mPolls += device.mPolls;
+		stats.mFixedRatePolls += fixedRatePolls;
+		stats.mBusMicrosSpent += static_cast<uint64_t>(device.mPolls) * device.mBusMicrosPerPoll;
+		if (fixedRatePolls > device.mPolls)
+			stats.mBusMicrosSaved += static_cast<uint64_t>(fixedRatePolls - device.mPolls) * device.mBusMicrosPerPoll;
+	}
+	return stats;
+}
+
+void AdaptivePoller::OnPoll(void* context_, TimerRegistry::Handle)
+{
+	Device& device = *static_cast<Device*>(context_);
+	AdaptivePoller& poller = *device.mOwner;
+	const DeviceId id = static_cast<DeviceId>(&device - poller.mDevices);
+
+	++device.mPolls;
+	if (device.mPoll && device.mPoll(device.mContext, id))
+	{
+		++device.mChanges;
+		poller.SetPeriod(device, device.mFastPeriodMillis);
+		return;
+	}
+
+	//	Quiet: stretch by mDecayPercent, at least by 1 ms so it keeps moving.
+	const uint32_t stretchMillis = static_cast<uint32_t>(static_cast<uint64_t>(device.mPeriodMillis) * poller.mConfig.mDecayPercent / 100);
+	const uint64_t periodMillis = static_cast<uint64_t>(device.mPeriodMillis) + (stretchMillis > 0 ? stretchMillis : 1);
+	poller.SetPeriod(device, periodMillis < device.mSlowPeriodMillis ? static_cast<uint32_t>(periodMillis) : device.mSlowPeriodMillis);
+}
+
+void AdaptivePoller::SetPeriod(Device& device_, uint32_t periodMillis_)
+{
+	if (periodMillis_ == device_.mPeriodMillis)
+		return;
+
+	//	Called from the poll, so the entry has already been re-armed at the old period.
+	device_.mPeriodMillis = periodMillis_;
+	mRegistry.ArmAt(device_.mHandle, mRegistry.Now() + periodMillis_, periodMillis_);
+}
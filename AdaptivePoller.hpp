@@ -0,0 +1,166 @@
+/**
+ * 	AdaptivePoller class.
+ *
+ * 	Polls many peripherals (f.e. I2C sensors) at a rate that follows their
+ * 	activity, instead of a fixed Timer interval that is too fast for idle
+ * 	devices and too slow for busy ones:
+ * 		- a poll that reports a changed reading, or an event reported with
+ * 			NotifyEvent() (or NotifyEventFromIsr() for f.e. a data-ready
+ * 			interrupt), sets the device to its fastest period right away;
+ * 		- every quiet poll stretches the period by mDecayPercent, up to the
+ * 			slowest period.
+ *
+ * 	Each device is a periodic TimerRegistry entry, so idle devices cost
+ * 	nothing between their polls. GetStats() compares the polls made with
+ * 	the polls a fixed fast rate would have made and converts the difference
+ * 	into bus time saved, using the bus time per poll declared for a device.
+ *
+ * There are a few things to keep in mind:
+ * 		- The poll callback returns true if the reading changed. What counts
+ * 			as a change (f.e. beyond noise) is up to the callback.
+ * 		- The next poll is scheduled one (new) period after the poll that
+ * 			changed it; an event schedules a poll right away.
+ * 		- NotifyEvent() arms the registry, so it must not be called from an
+ * 			interrupt. An ISR calls NotifyEventFromIsr(), which only sets a
+ * 			flag; ProcessEvents() in loop() (before Dispatch()) turns the
+ * 			flags into events.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+#include "TimerRegistry.hpp"
+
+class AdaptivePoller {
+
+public:
+
+	using DeviceId = uint16_t;
+	static constexpr DeviceId INVALID_DEVICE = 0xFFFF;
+
+	//	Reads the device; returns true if the reading changed.
+	using Poll = bool (*)(void* context_, DeviceId device_);
+
+	struct Config {
+		//	Stretch of the period per quiet poll, in percent.
+		uint8_t mDecayPercent{25};
+	};
+
+	struct Device {
+		AdaptivePoller* mOwner;
+		TimerRegistry::Handle mHandle;
+		Poll mPoll;
+		void* mContext;
+		uint32_t mFastPeriodMillis;
+		uint32_t mSlowPeriodMillis;
+		uint32_t mPeriodMillis;
+		uint32_t mBusMicrosPerPoll;
+		uint64_t mAddedMillis;
+		uint32_t mPolls;
+		uint32_t mChanges;
+	};
+
+	struct Stats {
+		uint32_t mPolls;
+		//	Polls at the fast period of every device over the same time.
+		uint32_t mFixedRatePolls;
+		uint64_t mBusMicrosSpent;
+		uint64_t mBusMicrosSaved;
+	};
+
+	/**
+	 * @brief Creates a poller on the passed storage (capacity_ devices and
+	 * 		as many event flags). Prefer StaticAdaptivePoller<N>.
+	 */
+	AdaptivePoller(TimerRegistry& registry_, Device* devices_, std::atomic<bool>* eventsPending_, uint16_t capacity_,
+					const Config& config_);
+	~AdaptivePoller();
+
+	AdaptivePoller(const AdaptivePoller&) = delete;
+	AdaptivePoller& operator=(const AdaptivePoller&) = delete;
+
+	/**
+	 * @brief Adds a device, starting at its fast period.
+	 *
+	 * @param fastPeriodMillis_: Period while active (highest rate).
+	 * @param slowPeriodMillis_: Period while idle (lowest rate).
+	 * @param busMicrosPerPoll_: Bus time one poll takes, for the statistics.
+	 * @return The device, INVALID_DEVICE if the poller or the registry is full.
+	 */
+	DeviceId Add(Poll poll_, void* context_, uint32_t fastPeriodMillis_, uint32_t slowPeriodMillis_,
+					uint32_t busMicrosPerPoll_ = 0);
+
+	void Remove(DeviceId device_);
+
+	/**
+	 * @brief Reports activity of the device: poll it now and at the fast period.
+	 */
+	void NotifyEvent(DeviceId device_);
+
+	/**
+	 * @brief Reports activity of the device from an interrupt. Only sets a
+	 * 		flag; the event takes effect in the next ProcessEvents().
+	 */
+	void NotifyEventFromIsr(DeviceId device_);
+
+	/**
+	 * @brief Turns events reported from interrupts into NotifyEvent() calls.
+	 * 		Call it from loop(); costs a single load if there are none.
+	 *
+	 * @return The number of events processed.
+	 */
+	uint16_t ProcessEvents();
+
+	/**
+	 * @brief Returns the current period of the device, 0 if unknown.
+	 */
+	uint32_t GetPeriod(DeviceId device_) const;
+
+	/**
+	 * @brief Sums up all devices.
+	 */
+	Stats GetStats() const;
+
+
+private:
+
+	static void OnPoll(void* context_, TimerRegistry::Handle handle_);
+
+	void SetPeriod(Device& device_, uint32_t periodMillis_);
+
+	TimerRegistry& mRegistry;
+	Device* mDevices;
+	//	Set by NotifyEventFromIsr(), per device and for any device.
+	std::atomic<bool>* mEventsPending;
+	std::atomic<bool> mAnyEventPending{false};
+	uint16_t mCapacity;
+	Config mConfig;
+
+};
+
+
+/**
+ * 	Storage for StaticAdaptivePoller, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct AdaptivePollerStorage {
+	AdaptivePoller::Device mDeviceStorage[CAPACITY];
+	std::atomic<bool> mEventPendingStorage[CAPACITY];
+};
+
+/**
+ * 	AdaptivePoller with built-in storage for CAPACITY devices.
+ */
+template <uint16_t CAPACITY>
+class StaticAdaptivePoller : private AdaptivePollerStorage<CAPACITY>, public AdaptivePoller {
+
+public:
+
+	explicit StaticAdaptivePoller(TimerRegistry& registry_, const Config& config_ = Config{}) :
+		AdaptivePoller(registry_, this->mDeviceStorage, this->mEventPendingStorage, CAPACITY, config_)
+	{
+	}
+
+};
@@ -0,0 +1,118 @@
+#include "BackgroundRunner.hpp"
+
+#include "Timer.hpp"
+
+BackgroundRunner::BackgroundRunner(const TimerRegistry& registry_, Job* jobs_, JobId capacity_, uint32_t guardBandMillis_) :
+	mRegistry(registry_),
+	mJobs(jobs_),
+	mCapacity(capacity_),
+	mGuardBandMillis(guardBandMillis_)
+{
+	for (JobId job = 0; job < mCapacity; ++job)
+		mJobs[job] = Job{};
+}
+
+BackgroundRunner::JobId BackgroundRunner::Add(Step step_, void* context_, uint32_t totalUnits_)
+{
+	for (JobId job = 0; job < mCapacity; ++job)
+	{
+		if (mJobs[job].mAllocated)
+			continue;
+
+		mJobs[job] = Job{};
+		mJobs[job].mStep = step_;
+		mJobs[job].mContext = context_;
+		mJobs[job].mTotalUnits = totalUnits_;
+		mJobs[job].mAllocated = true;
+		return job;
+	}
+	return INVALID_JOB;
+}
+
+void BackgroundRunner::Remove(JobId job_)
+{
+	if (IsValid(job_))
+		mJobs[job_] = Job{};
+}
+
+void BackgroundRunner::Restart(JobId job_)
+{
+	if (!IsValid(job_))
+		return;
+
+	mJobs[job_].mDoneUnits = 0;
+	mJobs[job_].mFinished = false;
+}
+
+uint16_t BackgroundRunner::Run(uint32_t budgetMillis_)
+{
+	const uint32_t startMillis = millis();
+	uint16_t chunks = 0;
+
+	for (;;)
+	{
+		const uint32_t nowMillis = millis();
+		if (nowMillis - startMillis >= budgetMillis_)
+			break;
+		if (mRegistry.TimeUntilNextDeadline(nowMillis) <= mGuardBandMillis)
+			break;
+
+		const JobId job = NextRunnable();
+		if (INVALID_JOB == job)
+			break;
+
+		Job& entry = mJobs[job];
+		uint32_t units = 0;
+		const uint32_t startMicros = micros();
+		const bool moreWork = entry.mStep(entry.mContext, units);
+		const uint32_t chunkMicros = micros() - startMicros;
+
+		entry.mDoneUnits += units;
+		entry.mUnitsProcessed += units;
+		entry.mBusyMicros += chunkMicros;
+		++entry.mChunks;
+		if (chunkMicros > entry.mMaxChunkMicros)
+			entry.mMaxChunkMicros = chunkMicros;
+		if (!moreWork)
+			entry.mFinished = true;
+		if (chunkMicros / 1000 > mGuardBandMillis)
+			++mOverrunCount;
+		++chunks;
+	}
+	return chunks;
+}
+
+uint8_t BackgroundRunner::ProgressPercent(JobId job_) const
+{
+	if (!IsValid(job_))
+		return 0;
+
+	const Job& job = mJobs[job_];
+	if (job.mFinished)
+		return 100;
+	if (0 == job.mTotalUnits)
+		return 0;
+	if (job.mDoneUnits >= job.mTotalUnits)
+		return 99;	// not finished until the step says so
+	return static_cast<uint8_t>(static_cast<uint64_t>(job.mDoneUnits) * 100 / job.mTotalUnits);
+}
+
+uint32_t BackgroundRunner::UnitsPerSecond(JobId job_) const
+{
+	if (!IsValid(job_) || 0 == mJobs[job_].mBusyMicros)
+		return 0;
+
+	return NarrowConvertToUint32(static_cast<uint64_t>(mJobs[job_].mUnitsProcessed) * 1000000 / mJobs[job_].mBusyMicros);
+}
+
+BackgroundRunner::JobId BackgroundRunner::NextRunnable()
+{
+	for (JobId tried = 0; tried < mCapacity; ++tried)
+	{
+		const JobId job = mCursor;
+		mCursor = static_cast<JobId>((mCursor + 1) % mCapacity);
+		if (mJobs[job].mAllocated && !mJobs[job].mFinished)
+			return job;
+	}
+	return INVALID_JOB;
+}
@@ -0,0 +1,164 @@
+/**
+ * 	BackgroundRunner class.
+ *
+ * 	Long jobs (f.e. a CRC over the flash, compaction, log compression)
+ * 	would block loop() and make every timer late. Here such jobs are
+ * 	written as resumable steps: each call of the step function does one
+ * 	small chunk of the work and returns. The runner calls the steps of
+ * 	all unfinished jobs in turn - but only while the time until the next
+ * 	deadline of a TimerRegistry exceeds a guard band. Once a deadline
+ * 	comes close, Run() returns and leaves the loop to Dispatch().
+ *
+ * 	Thus a timer is delayed by background work at most by the duration
+ * 	of a single chunk that started just before the guard band - so the
+ * 	guard band should be chosen larger than the longest chunk.
+ * 	Chunks that took longer than the guard band are counted as overruns.
+ *
+ * 	Jobs report their progress in freely chosen units (bytes, records..).
+ * 	Together with the measured busy time this gives progress and
+ * 	throughput per job.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <limits>
+
+#include "TimerRegistry.hpp"
+
+class BackgroundRunner {
+
+public:
+
+	using JobId = uint8_t;
+
+	/**
+	 * Runs one chunk of a job.
+	 *
+	 * @param context_: As passed to Add().
+	 * @param unitsDone_: To be set to the number of units processed by this chunk.
+	 * @return True while there is work left, false once the job is finished.
+	 */
+	using Step = bool (*)(void* context_, uint32_t& unitsDone_);
+
+	//	Returned by Add() if there is no free job slot.
+	static constexpr JobId INVALID_JOB = std::numeric_limits<JobId>::max();
+	//	Run()-parameter definition: no time budget apart from the guard band.
+	static constexpr uint32_t NO_BUDGET = std::numeric_limits<uint32_t>::max();
+
+	struct Job {
+		Step mStep{nullptr};
+		void* mContext{nullptr};
+		uint32_t mTotalUnits{0};
+		uint32_t mDoneUnits{0};
+		uint32_t mUnitsProcessed{0};
+		uint32_t mChunks{0};
+		uint64_t mBusyMicros{0};
+		uint32_t mMaxChunkMicros{0};
+		bool mAllocated{false};
+		bool mFinished{false};
+	};
+
+	/**
+	 * @brief Creates a runner on the passed job storage.
+	 * 		Prefer StaticBackgroundRunner<N>, which provides the storage.
+	 *
+	 * @param registry_: The registry whose next deadline bounds the background work.
+	 * @param guardBandMillis_: Minimum time left until the next deadline to start a chunk.
+	 */
+	BackgroundRunner(const TimerRegistry& registry_, Job* jobs_, JobId capacity_, uint32_t guardBandMillis_);
+
+	/**
+	 * @brief Adds a job. It is started on the next Run().
+	 *
+	 * @param totalUnits_: Expected total of units, used for progress only (0 = unknown).
+	 * @return The id of the job, INVALID_JOB if all slots are in use.
+	 */
+	JobId Add(Step step_, void* context_, uint32_t totalUnits_ = 0);
+
+	/**
+	 * @brief Releases the job slot.
+	 */
+	void Remove(JobId job_);
+
+	/**
+	 * @brief Starts a finished (or running) job over, f.e. for the next CRC pass.
+	 * 		Progress is reset, throughput statistics are kept.
+	 */
+	void Restart(JobId job_);
+
+	/**
+	 * @brief Runs chunks of the unfinished jobs round robin while the next
+	 * 		deadline is further away than the guard band.
+	 *
+	 * @param budgetMillis_: Additional limit for the time spent in this call.
+	 * @return The number of chunks run.
+	 */
+	uint16_t Run(uint32_t budgetMillis_ = NO_BUDGET);
+
+	auto SetGuardBand(uint32_t guardBandMillis_) -> void {mGuardBandMillis = guardBandMillis_;}
+	auto GetGuardBand() const -> uint32_t {return mGuardBandMillis;}
+
+	auto IsFinished(JobId job_) const -> bool {return IsValid(job_) && mJobs[job_].mFinished;}
+
+	/**
+	 * @brief Returns the progress of the job in percent (0 if the total is unknown
+	 * 		and the job is not finished yet).
+	 */
+	uint8_t ProgressPercent(JobId job_) const;
+
+	/**
+	 * @brief Returns the measured throughput of the job in units per second,
+	 * 		over all passes since Add().
+	 */
+	uint32_t UnitsPerSecond(JobId job_) const;
+
+	/**
+	 * @brief Returns the job's bookkeeping (progress, chunk count, busy time).
+	 */
+	auto GetJob(JobId job_) const -> const Job& {return mJobs[job_];}
+
+	/**
+	 * @brief Returns how often a chunk took longer than the guard band,
+	 * 		i.e. might have delayed a deadline.
+	 */
+	auto GetOverrunCount() const -> uint32_t {return mOverrunCount;}
+
+
+private:
+
+	auto IsValid(JobId job_) const -> bool {return job_ < mCapacity && mJobs[job_].mAllocated;}
+	JobId NextRunnable();
+
+	const TimerRegistry& mRegistry;
+	Job* mJobs;
+	JobId mCapacity;
+	JobId mCursor{0};
+	uint32_t mGuardBandMillis;
+	uint32_t mOverrunCount{0};
+
+};
+
+
+/**
+ * 	Storage for StaticBackgroundRunner, see TimerRegistryStorage.
+ */
+template <BackgroundRunner::JobId CAPACITY>
+struct BackgroundRunnerStorage {
+	BackgroundRunner::Job mJobStorage[CAPACITY];
+};
+
+/**
+ * 	BackgroundRunner with built-in storage for CAPACITY jobs.
+ */
+template <BackgroundRunner::JobId CAPACITY>
+class StaticBackgroundRunner : private BackgroundRunnerStorage<CAPACITY>, public BackgroundRunner {
+
+public:
+
+	StaticBackgroundRunner(const TimerRegistry& registry_, uint32_t guardBandMillis_) :
+		BackgroundRunner(registry_, this->mJobStorage, CAPACITY, guardBandMillis_)
+	{
+	}
+
+};
@@ -0,0 +1,100 @@
+#include "BatchFlusher.hpp"
+
+#include "Timer.hpp"
+
+BatchFlusher::BatchFlusher(TimerRegistry& registry_, uint8_t* buffer_, size_t capacity_, size_t flushThreshold_,
+							uint32_t maxAgeMillis_, Sink sink_, void* context_) :
+	mRegistry(registry_),
+	mBuffer(buffer_),
+	mCapacity(capacity_),
+	mFlushThreshold(flushThreshold_ < capacity_ ? flushThreshold_ : capacity_),
+	mMaxAgeMillis(maxAgeMillis_),
+	mSink(sink_),
+	mContext(context_),
+	mAgeHandle(registry_.Add(OnMaxAge, this))
+{
+}
+
+BatchFlusher::~BatchFlusher()
+{
+	mRegistry.Remove(mAgeHandle);
+}
+
+bool BatchFlusher::Append(const void* data_, size_t length_)
+{
+	if (length_ > mCapacity)
+	{
+		++mStats.mDroppedRecords;
+		return false;
+	}
+
+	if (mUsed + length_ > mCapacity && !Flush(FLUSH_SIZE))
+	{
+		++mStats.mDroppedRecords;
+		return false;
+	}
+
+	if (0 == mUsed)
+		mRegistry.ArmAfter(mAgeHandle, mMaxAgeMillis);
+
+	memcpy(mBuffer + mUsed, data_, length_);
+	mUsed += length_;
+
+	if (mUsed >= mFlushThreshold)
+		Flush(FLUSH_SIZE);
+	return true;
+}
+
+bool BatchFlusher::Flush()
+{
+	return Flush(FLUSH_EXPLICIT);
+}
+
+bool BatchFlusher::Flush(FlushReason reason_)
+{
+	if (0 == mUsed)
+		return true;
+
+	const uint32_t startMicros = micros();
+	const bool written = mSink(mContext, mBuffer, mUsed);
+	const uint32_t flushMicros = micros() - startMicros;
+
+	if (!written)
+	{
+		++mStats.mFailedFlushes;
+		mRegistry.ArmAfter(mAgeHandle, mMaxAgeMillis);
+		return false;
+	}
+
+	const uint32_t batchBytes = NarrowConvertToUint32(mUsed);
+	if (0 == mStats.mBatches || batchBytes < mStats.mMinBatchBytes)
+		mStats.mMinBatchBytes = batchBytes;
+	if (batchBytes > mStats.mMaxBatchBytes)
+		mStats.mMaxBatchBytes = batchBytes;
+	++mStats.mBatches;
+	++mStats.mFlushesByReason[reason_];
+	mStats.mFlushedBytes += batchBytes;
+	mStats.mLastFlushMicros = flushMicros;
+	mStats.mTotalFlushMicros += flushMicros;
+	if (flushMicros > mStats.mMaxFlushMicros)
+		mStats.mMaxFlushMicros = flushMicros;
+
+	mUsed = 0;
+	mRegistry.Cancel(mAgeHandle);
+	return true;
+}
+
+uint32_t BatchFlusher::GetBytesPerFlush() const
+{
+	return mStats.mBatches > 0 ? NarrowConvertToUint32(mStats.mFlushedBytes / mStats.mBatches) : 0;
+}
+
+uint32_t BatchFlusher::GetAverageFlushMicros() const
+{
+	return mStats.mBatches > 0 ? NarrowConvertToUint32(mStats.mTotalFlushMicros / mStats.mBatches) : 0;
+}
+
+void BatchFlusher::OnMaxAge(void* context_, TimerRegistry::Handle)
+{
+	static_cast<BatchFlusher*>(context_)->Flush(FLUSH_AGE);
+}
@@ -0,0 +1,150 @@
+/**
+ * 	BatchFlusher class.
+ *
+ * 	Collects records (f.e. sensor samples for the flash log or serial) in a
+ * 	fixed buffer and hands them to a sink in batches ("group commit").
+ * 	A batch is flushed as soon as either
+ * 		- the buffer holds flushThreshold_ bytes or more, or
+ * 		- the oldest record in the buffer has reached maxAgeMillis_,
+ * 	whichever comes first. So bursts cannot overflow the buffer, and quiet
+ * 	periods do not delay records longer than the configured age.
+ *
+ * 	The age deadline is a TimerRegistry entry, armed when the first record
+ * 	enters an empty buffer - an idle flusher costs no polling.
+ *
+ * There are a few things to keep in mind:
+ * 		- Records are never split: one that does not fit behind the buffered
+ * 			data triggers a flush first; one larger than the whole buffer is
+ * 			rejected.
+ * 		- If the sink fails (returns false), the data stays buffered and the
+ * 			flush is retried after maxAgeMillis_. Records that do not fit in
+ * 			the meantime are dropped and counted.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class BatchFlusher {
+
+public:
+
+	/**
+	 * Writes one batch.
+	 *
+	 * @return True on success. On false the batch is kept and retried later.
+	 */
+	using Sink = bool (*)(void* context_, const uint8_t* data_, size_t length_);
+
+	enum FlushReason : uint8_t {
+		FLUSH_SIZE,
+		FLUSH_AGE,
+		FLUSH_EXPLICIT,
+		FLUSH_REASON_COUNT
+	};
+
+	struct Stats {
+		uint32_t mBatches{0};
+		uint32_t mFlushesByReason[FLUSH_REASON_COUNT]{};
+		uint32_t mFailedFlushes{0};
+		uint64_t mFlushedBytes{0};
+		uint32_t mMinBatchBytes{0};
+		uint32_t mMaxBatchBytes{0};
+		uint32_t mLastFlushMicros{0};
+		uint32_t mMaxFlushMicros{0};
+		uint64_t mTotalFlushMicros{0};
+		uint32_t mDroppedRecords{0};
+	};
+
+	/**
+	 * @brief Creates an empty flusher on the passed buffer.
+	 *
+	 * @param buffer_: Storage for the batch.
+	 * @param capacity_: Size of the buffer in bytes.
+	 * @param flushThreshold_: Fill level (bytes) that triggers a flush.
+	 * @param maxAgeMillis_: Maximum time a record waits in the buffer.
+	 * @param sink_: Called with each batch.
+	 * @param context_: Passed through to the sink.
+	 */
+	BatchFlusher(TimerRegistry& registry_, uint8_t* buffer_, size_t capacity_, size_t flushThreshold_,
+					uint32_t maxAgeMillis_, Sink sink_, void* context_);
+	~BatchFlusher();
+
+	BatchFlusher(const BatchFlusher&) = delete;
+	BatchFlusher& operator=(const BatchFlusher&) = delete;
+
+	/**
+	 * @brief Appends a record, flushing before (if it does not fit) or
+	 * 		after (if the threshold is reached) as needed.
+	 *
+	 * @return False if the record was dropped.
+	 */
+	bool Append(const void* data_, size_t length_);
+
+	/**
+	 * @brief Flushes the buffered records now (f.e. before sleeping).
+	 *
+	 * @return False if the sink failed.
+	 */
+	bool Flush();
+
+	auto GetBufferedBytes() const -> size_t {return mUsed;}
+	auto GetStats() const -> const Stats& {return mStats;}
+
+	/**
+	 * @brief Returns the average batch size, the flush efficiency in bytes per flush.
+	 */
+	uint32_t GetBytesPerFlush() const;
+
+	/**
+	 * @brief Returns the average time spent in the sink per batch.
+	 */
+	uint32_t GetAverageFlushMicros() const;
+
+	auto ResetStats() -> void {mStats = Stats{};}
+
+
+private:
+
+	static void OnMaxAge(void* context_, TimerRegistry::Handle handle_);
+
+	bool Flush(FlushReason reason_);
+
+	TimerRegistry& mRegistry;
+	uint8_t* mBuffer;
+	size_t mCapacity;
+	size_t mFlushThreshold;
+	uint32_t mMaxAgeMillis;
+	Sink mSink;
+	void* mContext;
+	TimerRegistry::Handle mAgeHandle;
+	size_t mUsed{0};
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticBatchFlusher, see TimerRegistryStorage.
+ */
+template <size_t CAPACITY>
+struct BatchFlusherStorage {
+	uint8_t mBufferStorage[CAPACITY];
+};
+
+/**
+ * 	BatchFlusher with a built-in buffer of CAPACITY bytes.
+ */
+template <size_t CAPACITY>
+class StaticBatchFlusher : private BatchFlusherStorage<CAPACITY>, public BatchFlusher {
+
+public:
+
+	StaticBatchFlusher(TimerRegistry& registry_, size_t flushThreshold_, uint32_t maxAgeMillis_, Sink sink_, void* context_) :
+		BatchFlusher(registry_, this->mBufferStorage, CAPACITY, flushThreshold_, maxAgeMillis_, sink_, context_)
+	{
+	}
+
+};
@@ -0,0 +1,133 @@
+#include "ChangeReporter.hpp"
+
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+	//	Classification of a channel in one evaluation.
+	constexpr uint8_t VERDICT_CHANGE = 0;
+	constexpr uint8_t VERDICT_HEARTBEAT = 1;
+	constexpr uint8_t VERDICT_DEADBAND = 2;
+	constexpr uint8_t VERDICT_RATE_LIMIT = 3;
+
+	//	Free function with restrict parameters and selects only, so the loop vectorizes.
+	void ClassifyChannels(const float* __restrict value_, const float* __restrict reported_, const float* __restrict deadband_,
+							const uint32_t* __restrict reportedAt_, uint8_t* __restrict verdict_, uint32_t channels_,
+							uint32_t nowMillis_, uint32_t minIntervalMillis_, uint32_t maxIntervalMillis_)
+	{
+		for (uint32_t channel = 0; channel < channels_; ++channel)
+		{
+			const uint32_t elapsedMillis = nowMillis_ - reportedAt_[channel];
+			//	The difference is NaN if either side is, which never exceeds the deadband.
+			//	Bitwise operators: no short-circuit branches in the loop.
+			const bool valueNan = isnan(value_[channel]);
+			const bool reportedNan = isnan(reported_[channel]);
+			const bool changed = (fabsf(value_[channel] - reported_[channel]) > deadband_[channel]) | (valueNan != reportedNan);
+			const uint8_t ifChanged = elapsedMillis >= minIntervalMillis_ ? VERDICT_CHANGE : VERDICT_RATE_LIMIT;
+			const uint8_t ifQuiet = (elapsedMillis >= maxIntervalMillis_) & !(valueNan & reportedNan)
+										? VERDICT_HEARTBEAT
+										: VERDICT_DEADBAND;
+			verdict_[channel] = changed ? ifChanged : ifQuiet;
+		}
+	}
+
+}
+
+ChangeReporter::ChangeReporter(TimerRegistry& registry_, const Storage& storage_, uint16_t channels_,
+								const Config& config_, Sink sink_, void* context_) :
+	mRegistry(registry_),
+	mStorage(storage_),
+	mChannels(channels_),
+	mConfig(config_),
+	mSink(sink_),
+	mContext(context_),
+	mHandle(registry_.Add(OnEvaluate, this))
+{
+	if (mConfig.mMaxIntervalMillis < mConfig.mMinIntervalMillis)
+		mConfig.mMaxIntervalMillis = mConfig.mMinIntervalMillis;
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+	{
+		mStorage.mValue[channel] = NAN;
+		mStorage.mReported[channel] = NAN;
+		mStorage.mDeadband[channel] = 0.0f;
+		mStorage.mReportedAtMillis[channel] = 0;
+	}
+}
+
+ChangeReporter::~ChangeReporter()
+{
+	mRegistry.Remove(mHandle);
+}
+
+void ChangeReporter::Start()
+{
+	//	Backdate the last reports, so every channel is due as heartbeat.
+	const uint32_t dueMillis = static_cast<uint32_t>(mRegistry.Now()) - mConfig.mMaxIntervalMillis;
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+		mStorage.mReportedAtMillis[channel] = dueMillis;
+	mRegistry.ArmAfter(mHandle, 0, mConfig.mEvaluationMillis);
+}
+
+void ChangeReporter::Stop()
+{
+	mRegistry.Cancel(mHandle);
+}
+
+void ChangeReporter::SetValue(uint16_t channel_, float value_)
+{
+	if (channel_ < mChannels)
+		mStorage.mValue[channel_] = value_;
+}
+
+void ChangeReporter::SetValues(const float* values_)
+{
+	memcpy(mStorage.mValue, values_, mChannels * sizeof(float));
+}
+
+void ChangeReporter::SetDeadband(uint16_t channel_, float deadband_)
+{
+	if (channel_ < mChannels)
+		mStorage.mDeadband[channel_] = deadband_;
+}
+
+uint16_t ChangeReporter::Evaluate()
+{
+	const uint32_t nowMillis = static_cast<uint32_t>(mRegistry.Now());
+	ClassifyChannels(mStorage.mValue, mStorage.mReported, mStorage.mDeadband, mStorage.mReportedAtMillis,
+						mStorage.mVerdict, mChannels, nowMillis, mConfig.mMinIntervalMillis, mConfig.mMaxIntervalMillis);
+	++mStats.mEvaluations;
+
+	uint16_t reports = 0;
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+	{
+		const uint8_t verdict = mStorage.mVerdict[channel];
+		if (VERDICT_DEADBAND == verdict)
+		{
+			++mStats.mSuppressedDeadband;
+			continue;
+		}
+		if (VERDICT_RATE_LIMIT == verdict)
+		{
+			++mStats.mSuppressedRateLimit;
+			continue;
+		}
+
+		const float value = mStorage.mValue[channel];
+		mStorage.mReported[channel] = value;
+		mStorage.mReportedAtMillis[channel] = nowMillis;
+		++reports;
+		if (VERDICT_CHANGE == verdict)
+			++mStats.mChangeReports;
+		else
+			++mStats.mHeartbeats;
+		if (mSink)
+			mSink(mContext, channel, value, VERDICT_CHANGE == verdict ? REPORT_CHANGE : REPORT_HEARTBEAT);
+	}
+	return reports;
+}
+
+void ChangeReporter::OnEvaluate(void* context_, TimerRegistry::Handle)
+{
+	static_cast<ChangeReporter*>(context_)->Evaluate();
+}
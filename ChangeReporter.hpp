@@ -0,0 +1,157 @@
+/**
+ * 	ChangeReporter class.
+ *
+ * 	Report-on-change for telemetry, instead of publishing every channel on
+ * 	a fixed Timer interval whether it changed or not. A channel is reported
+ * 	when
+ * 		- its value moved out of the deadband around the value reported last,
+ * 			but not sooner than mMinIntervalMillis after the last report, or
+ * 		- mMaxIntervalMillis passed since its last report (heartbeat), so
+ * 			the receiver can tell a quiet channel from a dead one.
+ *
+ * 	The application stores the latest values with SetValue() / SetValues()
+ * 	whenever it likes; a periodic TimerRegistry entry evaluates all
+ * 	channels every mEvaluationMillis and hands the ones due to the sink.
+ * 	The evaluation first classifies all channels in one straight loop over
+ * 	packed arrays (which the compiler can vectorize) and only then calls the
+ * 	sink for the few that are due. Messages that a fixed-interval publisher
+ * 	would have sent are counted as suppressed, split by reason.
+ *
+ * There are a few things to keep in mind:
+ * 		- Storage is passed in by the owner. StaticChangeReporter<C> bundles
+ * 			the storage for C channels.
+ * 		- Every channel holding a value is reported on the first evaluation
+ * 			after Start().
+ * 		- Deadbands are absolute (same unit as the values), 0 by default,
+ * 			i.e. any change is reported.
+ * 		- Channels start as NaN (not set). A change from or to NaN is
+ * 			reported; a channel holding NaN that was reported as NaN (f.e.
+ * 			never set) gets no heartbeats.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class ChangeReporter {
+
+public:
+
+	enum ReportReason : uint8_t {
+		REPORT_CHANGE,
+		REPORT_HEARTBEAT
+	};
+
+	using Sink = void (*)(void* context_, uint16_t channel_, float value_, ReportReason reason_);
+
+	struct Config {
+		uint32_t mEvaluationMillis{100};
+		uint32_t mMinIntervalMillis{1000};
+		uint32_t mMaxIntervalMillis{60000};
+	};
+
+	/**
+	 * Storage pointers, one element per channel each.
+	 */
+	struct Storage {
+		float* mValue;
+		float* mReported;
+		float* mDeadband;
+		//	Low 32 bits of the time of the last report.
+		uint32_t* mReportedAtMillis;
+		//	Scratch space for the classification pass.
+		uint8_t* mVerdict;
+	};
+
+	struct Stats {
+		uint32_t mEvaluations{0};
+		uint32_t mChangeReports{0};
+		uint32_t mHeartbeats{0};
+		//	Not reported: within the deadband / changed, but within the minimum interval.
+		uint32_t mSuppressedDeadband{0};
+		uint32_t mSuppressedRateLimit{0};
+	};
+
+	/**
+	 * @brief Creates a stopped reporter. Prefer StaticChangeReporter<C>.
+	 */
+	ChangeReporter(TimerRegistry& registry_, const Storage& storage_, uint16_t channels_,
+					const Config& config_, Sink sink_, void* context_);
+	~ChangeReporter();
+
+	ChangeReporter(const ChangeReporter&) = delete;
+	ChangeReporter& operator=(const ChangeReporter&) = delete;
+
+	/**
+	 * @brief Starts evaluating; every channel is due on the first evaluation.
+	 */
+	void Start();
+	void Stop();
+
+	void SetValue(uint16_t channel_, float value_);
+
+	/**
+	 * @brief Stores the latest value of every channel (values_ holds one per channel).
+	 */
+	void SetValues(const float* values_);
+
+	void SetDeadband(uint16_t channel_, float deadband_);
+
+	/**
+	 * @brief Evaluates all channels now (called periodically after Start()).
+	 *
+	 * @return The number of reports made.
+	 */
+	uint16_t Evaluate();
+
+	auto GetStats() const -> const Stats& {return mStats;}
+	auto GetChannelCount() const -> uint16_t {return mChannels;}
+
+
+private:
+
+	static void OnEvaluate(void* context_, TimerRegistry::Handle handle_);
+
+	TimerRegistry& mRegistry;
+	Storage mStorage;
+	uint16_t mChannels;
+	Config mConfig;
+	Sink mSink;
+	void* mContext;
+	TimerRegistry::Handle mHandle;
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticChangeReporter, see TimerRegistryStorage.
+ */
+template <uint16_t CHANNELS>
+struct ChangeReporterStorage {
+	float mValueStorage[CHANNELS];
+	float mReportedStorage[CHANNELS];
+	float mDeadbandStorage[CHANNELS];
+	uint32_t mReportedAtStorage[CHANNELS];
+	uint8_t mVerdictStorage[CHANNELS];
+};
+
+/**
+ * 	ChangeReporter with built-in storage for CHANNELS channels.
+ */
+template <uint16_t CHANNELS>
+class StaticChangeReporter : private ChangeReporterStorage<CHANNELS>, public ChangeReporter {
+
+public:
+
+	StaticChangeReporter(TimerRegistry& registry_, const Config& config_, Sink sink_, void* context_) :
+		ChangeReporter(registry_,
+						{this->mValueStorage, this->mReportedStorage, this->mDeadbandStorage,
+							this->mReportedAtStorage, this->mVerdictStorage},
+						CHANNELS, config_, sink_, context_)
+	{
+	}
+
+};
@@ -0,0 +1,139 @@
+#include "CircuitBreaker.hpp"
+
+CircuitBreaker::CircuitBreaker(TimerRegistry& registry_, const Config& config_) :
+	mRegistry(registry_),
+	mConfig(config_),
+	mTimeoutHandle(registry_.Add(OnOpenTimeout, this))
+{
+	if (0 == mConfig.mWindowSize || mConfig.mWindowSize > WINDOW_MAX)
+		mConfig.mWindowSize = WINDOW_MAX;
+	if (mConfig.mMinimumCalls > mConfig.mWindowSize)
+		mConfig.mMinimumCalls = mConfig.mWindowSize;
+	if (0 == mConfig.mProbeCount)
+		mConfig.mProbeCount = 1;
+}
+
+CircuitBreaker::~CircuitBreaker()
+{
+	mRegistry.Remove(mTimeoutHandle);
+}
+
+bool CircuitBreaker::AllowRequest()
+{
+	switch (mState)
+	{
+	case STATE_CLOSED:
+		return true;
+
+	case STATE_HALF_OPEN:
+		if (mProbesAllowed < mConfig.mProbeCount)
+		{
+			++mProbesAllowed;
+			return true;
+		}
+		break;
+
+	case STATE_OPEN:
+		break;
+	}
+	++mTelemetry.mRejected;
+	return false;
+}
+
+void CircuitBreaker::RecordSuccess()
+{
+	Record(false);
+}
+
+void CircuitBreaker::RecordFailure()
+{
+	Record(true);
+}
+
+void CircuitBreaker::Reset()
+{
+	mRegistry.Cancel(mTimeoutHandle);
+	mState = STATE_CLOSED;
+	ClearWindow();
+}
+
+uint8_t CircuitBreaker::GetFailureRatePercent() const
+{
+	return mCalls > 0 ? static_cast<uint8_t>(static_cast<uint16_t>(mFailures) * 100 / mCalls) : 0;
+}
+
+void CircuitBreaker::OnOpenTimeout(void* context_, TimerRegistry::Handle)
+{
+	CircuitBreaker& breaker = *static_cast<CircuitBreaker*>(context_);
+	breaker.mState = STATE_HALF_OPEN;
+	breaker.mProbesAllowed = 0;
+	breaker.mProbesSucceeded = 0;
+	++breaker.mTelemetry.mHalfOpens;
+}
+
+void CircuitBreaker::Record(bool failed_)
+{
+	switch (mState)
+	{
+	case STATE_CLOSED:
+	{
+		//	Replace the oldest outcome once the window is full.
+		const uint64_t bit = 1ull << mNext;
+		if (mCalls == mConfig.mWindowSize)
+		{
+			if (mOutcomes & bit)
+				--mFailures;
+		}
+		else
+			++mCalls;
+
+		if (failed_)
+		{
+			mOutcomes |= bit;
+			++mFailures;
+		}
+		else
+			mOutcomes &= ~bit;
+		mNext = static_cast<uint8_t>((mNext + 1) % mConfig.mWindowSize);
+
+		if (mCalls >= mConfig.mMinimumCalls
+			&& static_cast<uint16_t>(mFailures) * 100 >= static_cast<uint16_t>(mConfig.mFailureRatePercent) * mCalls)
+		{
+			++mTelemetry.mTrips;
+			Open();
+		}
+		break;
+	}
+
+	case STATE_HALF_OPEN:
+		if (failed_)
+		{
+			++mTelemetry.mProbeFailures;
+			Open();
+		}
+		else if (++mProbesSucceeded >= mConfig.mProbeCount)
+		{
+			++mTelemetry.mRecoveries;
+			mState = STATE_CLOSED;
+			ClearWindow();
+		}
+		break;
+
+	case STATE_OPEN:
+		break;
+	}
+}
+
+void CircuitBreaker::Open()
+{
+	mState = STATE_OPEN;
+	mRegistry.ArmAfter(mTimeoutHandle, mConfig.mOpenTimeoutMillis);
+}
+
+void CircuitBreaker::ClearWindow()
+{
+	mOutcomes = 0;
+	mNext = 0;
+	mCalls = 0;
+	mFailures = 0;
+}
@@ -0,0 +1,122 @@
+/**
+ * 	CircuitBreaker class.
+ *
+ * 	Stops calling a failing downstream (sensor, broker, ...) instead of
+ * 	hammering it every interval with calls that are doomed to fail:
+ * 		- closed: calls pass. The outcomes of the last mWindowSize calls are
+ * 			kept; if at least mMinimumCalls were made and the share of
+ * 			failures reaches mFailureRatePercent, the breaker opens.
+ * 		- open: calls are rejected right away (AllowRequest() is O(1)). A
+ * 			registry entry moves the breaker to half-open after
+ * 			mOpenTimeoutMillis.
+ * 		- half-open: up to mProbeCount calls are let through as probes. If
+ * 			all of them succeed, the breaker closes; a single failure opens
+ * 			it again for another timeout.
+ *
+ * 	Usage: ask AllowRequest() before each call and report its outcome with
+ * 	RecordSuccess() / RecordFailure(). Nothing is allocated; the window is
+ * 	a 64 bit outcome mask.
+ *
+ * There are a few things to keep in mind:
+ * 		- The window counts calls, not time. mWindowSize is limited to
+ * 			WINDOW_MAX calls.
+ * 		- Outcomes reported while open (f.e. of calls started before the
+ * 			breaker opened) are ignored.
+ * 		- Every transition and every rejected call is counted in the
+ * 			Telemetry for monitoring.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class CircuitBreaker {
+
+public:
+
+	static constexpr uint8_t WINDOW_MAX = 64;
+
+	enum BreakerState : uint8_t {
+		STATE_CLOSED,
+		STATE_OPEN,
+		STATE_HALF_OPEN
+	};
+
+	struct Config {
+		uint8_t mWindowSize{20};
+		uint8_t mMinimumCalls{10};
+		uint8_t mFailureRatePercent{50};
+		uint32_t mOpenTimeoutMillis{10000};
+		uint8_t mProbeCount{1};
+	};
+
+	struct Telemetry {
+		//	Closed -> open.
+		uint32_t mTrips{0};
+		//	Open -> half-open.
+		uint32_t mHalfOpens{0};
+		//	Half-open -> closed.
+		uint32_t mRecoveries{0};
+		//	Half-open -> open (a probe failed).
+		uint32_t mProbeFailures{0};
+		//	Calls rejected by AllowRequest().
+		uint32_t mRejected{0};
+	};
+
+	CircuitBreaker(TimerRegistry& registry_, const Config& config_);
+	~CircuitBreaker();
+
+	CircuitBreaker(const CircuitBreaker&) = delete;
+	CircuitBreaker& operator=(const CircuitBreaker&) = delete;
+
+	/**
+	 * @brief Returns true if a call may be made now. Counts rejections.
+	 */
+	bool AllowRequest();
+
+	void RecordSuccess();
+	void RecordFailure();
+
+	/**
+	 * @brief Closes the breaker and clears the window (f.e. after a reconfiguration).
+	 */
+	void Reset();
+
+	auto GetState() const -> BreakerState {return mState;}
+	auto IsOpen() const -> bool {return STATE_OPEN == mState;}
+	auto GetTelemetry() const -> const Telemetry& {return mTelemetry;}
+
+	/**
+	 * @brief Returns the failure share of the current window, in percent.
+	 */
+	uint8_t GetFailureRatePercent() const;
+
+
+private:
+
+	static void OnOpenTimeout(void* context_, TimerRegistry::Handle handle_);
+
+	void Record(bool failed_);
+	void Open();
+	void ClearWindow();
+
+	TimerRegistry& mRegistry;
+	Config mConfig;
+	TimerRegistry::Handle mTimeoutHandle;
+	BreakerState mState{STATE_CLOSED};
+
+	//	Outcomes of the window, bit set = failure; the newest at bit mNext - 1.
+	uint64_t mOutcomes{0};
+	uint8_t mNext{0};
+	uint8_t mCalls{0};
+	uint8_t mFailures{0};
+
+	//	Half-open: probes let through and probes that succeeded.
+	uint8_t mProbesAllowed{0};
+	uint8_t mProbesSucceeded{0};
+
+	Telemetry mTelemetry;
+
+};
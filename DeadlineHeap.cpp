@@ -0,0 +1,94 @@
+#include "DeadlineHeap.hpp"
+
+DeadlineHeap::DeadlineHeap(Node* nodes_, uint16_t* positions_, uint16_t capacity_) :
+	mNodes(nodes_),
+	mPositions(positions_),
+	mCapacity(capacity_)
+{
+	for (uint16_t id = 0; id < mCapacity; ++id)
+		mPositions[id] = INVALID_ID;
+}
+
+void DeadlineHeap::Update(uint16_t id_, uint64_t deadline_)
+{
+	if (id_ >= mCapacity)
+		return;
+
+	uint16_t position = mPositions[id_];
+	if (INVALID_ID == position)
+	{
+		position = mSize++;
+		Place(position, Node{deadline_, id_});
+		SiftUp(position);
+		return;
+	}
+
+	const uint64_t previous = mNodes[position].mDeadline;
+	mNodes[position].mDeadline = deadline_;
+	if (deadline_ < previous)
+		SiftUp(position);
+	else
+		SiftDown(position);
+}
+
+void DeadlineHeap::Remove(uint16_t id_)
+{
+	if (id_ < mCapacity && mPositions[id_] != INVALID_ID)
+		RemoveAt(mPositions[id_]);
+}
+
+void DeadlineHeap::Pop()
+{
+	RemoveAt(0);
+}
+
+void DeadlineHeap::RemoveAt(uint16_t position_)
+{
+	mPositions[mNodes[position_].mId] = INVALID_ID;
+	if (--mSize == position_)
+		return;
+
+	//	Move the last node into the gap; it may have to travel either way.
+	Place(position_, mNodes[mSize]);
+	const uint16_t movedId = mNodes[position_].mId;
+	SiftUp(position_);
+	SiftDown(mPositions[movedId]);
+}
+
+void DeadlineHeap::SiftUp(uint16_t position_)
+{
+	const Node node = mNodes[position_];
+	while (position_ > 0)
+	{
+		const uint16_t parent = (position_ - 1) / 2;
+		if (mNodes[parent].mDeadline <= node.mDeadline)
+			break;
+		Place(position_, mNodes[parent]);
+		position_ = parent;
+	}
+	Place(position_, node);
+}
+
+void DeadlineHeap::SiftDown(uint16_t position_)
+{
+	const Node node = mNodes[position_];
+	for (;;)
+	{
+		uint32_t child = 2u * position_ + 1u;
+		if (child >= mSize)
+			break;
+		if (child + 1u < mSize && mNodes[child + 1u].mDeadline < mNodes[child].mDeadline)
+			++child;
+		if (node.mDeadline <= mNodes[child].mDeadline)
+			break;
+		Place(position_, mNodes[child]);
+		position_ = static_cast<uint16_t>(child);
+	}
+	Place(position_, node);
+}
+
+void DeadlineHeap::Place(uint16_t position_, const Node& node_)
+{
+	mNodes[position_] = node_;
+	mPositions[node_.mId] = position_;
+}
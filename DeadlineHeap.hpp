@@ -0,0 +1,89 @@
+/**
+ * 	DeadlineHeap class.
+ *
+ * 	An indexed binary min-heap of (deadline, id) pairs, ordered by deadline.
+ * 	Ids are small integers below the capacity (f.e. slot numbers of a
+ * 	fixed table). A position table maps every id to its place in the heap,
+ * 	so an id can be updated or removed in O(log n) without searching.
+ *
+ * 	The heap does not allocate: node and position storage is passed in
+ * 	by the owner, which usually keeps it in static arrays.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <limits>
+
+class DeadlineHeap {
+
+public:
+
+	//	Id / position value for "not in the heap".
+	static constexpr uint16_t INVALID_ID = std::numeric_limits<uint16_t>::max();
+
+	struct Node {
+		uint64_t mDeadline;
+		uint16_t mId;
+	};
+
+	/**
+	 * @brief Creates an empty heap on the passed storage.
+	 *
+	 * @param nodes_: Storage for capacity_ heap nodes.
+	 * @param positions_: Storage for capacity_ positions (indexed by id).
+	 * @param capacity_: Number of ids (0 .. capacity_ - 1) the heap can hold.
+	 */
+	DeadlineHeap(Node* nodes_, uint16_t* positions_, uint16_t capacity_);
+
+	/**
+	 * @brief Inserts the id with the passed deadline or, if the id is
+	 * 		already contained, moves it to the new deadline.
+	 */
+	void Update(uint16_t id_, uint64_t deadline_);
+
+	/**
+	 * @brief Removes the id if contained, otherwise does nothing.
+	 */
+	void Remove(uint16_t id_);
+
+	/**
+	 * @brief Removes the earliest node. Heap must not be empty.
+	 */
+	void Pop();
+
+	auto Contains(uint16_t id_) const -> bool {return mPositions[id_] != INVALID_ID;}
+	auto IsEmpty() const -> bool {return mSize == 0;}
+	auto Size() const -> uint16_t {return mSize;}
+	auto Capacity() const -> uint16_t {return mCapacity;}
+
+	/**
+	 * @brief Returns the earliest node. Heap must not be empty.
+	 */
+	auto Top() const -> const Node& {return mNodes[0];}
+
+	/**
+	 * @brief Returns the node at the passed heap position (0 = earliest;
+	 * 		children of i are at 2i+1 and 2i+2). Used for read-only walks.
+	 */
+	auto NodeAt(uint16_t position_) const -> const Node& {return mNodes[position_];}
+
+	/**
+	 * @brief Returns the deadline of a contained id.
+	 */
+	auto DeadlineOf(uint16_t id_) const -> uint64_t {return mNodes[mPositions[id_]].mDeadline;}
+
+
+private:
+
+	void RemoveAt(uint16_t position_);
+	void SiftUp(uint16_t position_);
+	void SiftDown(uint16_t position_);
+	void Place(uint16_t position_, const Node& node_);
+
+	Node* mNodes;
+	uint16_t* mPositions;
+	uint16_t mCapacity;
+	uint16_t mSize{0};
+
+};
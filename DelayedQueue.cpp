@@ -0,0 +1,162 @@
+#include "DelayedQueue.hpp"
+
+#include <string.h>
+
+#include "Timer.hpp"
+
+DelayedQueue::DelayedQueue(TimerRegistry& registry_, const Storage& storage_, uint16_t capacity_, uint16_t payloadSize_,
+							Handler handler_, void* context_) :
+	mRegistry(registry_),
+	mSlots(storage_.mSlots),
+	mArena(storage_.mArena),
+	mHeap(storage_.mNodes, storage_.mPositions, capacity_),
+	mCapacity(capacity_),
+	mPayloadSize(payloadSize_),
+	mHandler(handler_),
+	mContext(context_),
+	mHandle(registry_.Add(OnDue, this))
+{
+	for (uint16_t slot = 0; slot < mCapacity; ++slot)
+		mSlots[slot] = Slot{0, 0, 0, static_cast<uint16_t>(slot + 1 < mCapacity ? slot + 1 : INVALID_SLOT), SLOT_FREE};
+	mFreeSlot = mCapacity > 0 ? 0 : INVALID_SLOT;
+}
+
+DelayedQueue::~DelayedQueue()
+{
+	mRegistry.Remove(mHandle);
+}
+
+DelayedQueue::MessageId DelayedQueue::PostAt(uint64_t deadlineMillis_, uint16_t type_, const void* payload_, uint16_t length_)
+{
+	if (INVALID_SLOT == mFreeSlot || length_ > mPayloadSize)
+	{
+		++mStats.mRejected;
+		return INVALID_MESSAGE;
+	}
+
+	const uint16_t slot = mFreeSlot;
+	Slot& message = mSlots[slot];
+	mFreeSlot = message.mNext;
+	message.mType = type_;
+	message.mLength = length_;
+	message.mNext = INVALID_SLOT;
+	message.mState = SLOT_QUEUED;
+	if (length_ > 0)
+		memcpy(mArena + static_cast<size_t>(slot) * mPayloadSize, payload_, length_);
+
+	const bool earliest = mHeap.IsEmpty() || deadlineMillis_ < mHeap.Top().mDeadline;
+	mHeap.Update(slot, deadlineMillis_);
+	if (earliest)
+		Rearm();
+
+	++mStats.mPosted;
+	if (mHeap.Size() > mStats.mPeakQueued)
+		mStats.mPeakQueued = mHeap.Size();
+	return static_cast<MessageId>(message.mGeneration) << 16 | slot;
+}
+
+DelayedQueue::MessageId DelayedQueue::PostAfter(uint32_t delayMillis_, uint16_t type_, const void* payload_, uint16_t length_)
+{
+	return PostAt(mRegistry.Now() + delayMillis_, type_, payload_, length_);
+}
+
+bool DelayedQueue::Cancel(MessageId message_)
+{
+	const uint16_t slot = SlotOf(message_);
+	if (INVALID_SLOT == slot)
+		return false;
+
+	++mStats.mCancelled;
+	//	Taken by the running drain: it skips (and releases) the message.
+	if (SLOT_DUE == mSlots[slot].mState)
+	{
+		mSlots[slot].mState = SLOT_CANCELLED;
+		return true;
+	}
+
+	const bool earliest = mHeap.Top().mId == slot;
+	mHeap.Remove(slot);
+	Release(slot);
+	if (earliest)
+		Rearm();
+	return true;
+}
+
+uint16_t DelayedQueue::Drain()
+{
+	const uint64_t nowMillis = mRegistry.Now();
+
+	//	Take the due messages first, in deadline order, so whatever the handlers post waits for the next drain.
+	uint16_t first = INVALID_SLOT;
+	uint16_t* last = &first;
+	while (!mHeap.IsEmpty() && mHeap.Top().mDeadline <= nowMillis)
+	{
+		const uint16_t slot = mHeap.Top().mId;
+		const uint32_t latenessMillis = NarrowConvertToUint32(nowMillis - mHeap.Top().mDeadline);
+		if (latenessMillis > mStats.mMaxLatenessMillis)
+			mStats.mMaxLatenessMillis = latenessMillis;
+		mHeap.Pop();
+
+		Slot& message = mSlots[slot];
+		message.mState = SLOT_DUE;
+		message.mNext = INVALID_SLOT;
+		*last = slot;
+		last = &message.mNext;
+	}
+
+	uint16_t delivered = 0;
+	while (INVALID_SLOT != first)
+	{
+		const uint16_t slot = first;
+		Slot& message = mSlots[slot];
+		first = message.mNext;
+		if (SLOT_DUE == message.mState)
+		{
+			//	Being delivered, so not cancellable; the slot is released after the handler.
+			message.mState = SLOT_FREE;
+			if (mHandler)
+				mHandler(mContext, message.mType, mArena + static_cast<size_t>(slot) * mPayloadSize, message.mLength);
+			++delivered;
+		}
+		Release(slot);
+	}
+
+	mStats.mDelivered += delivered;
+	//	Posted for now by the handlers: on a later Dispatch(), so handlers posting again and again cannot keep one busy.
+	if (!mHeap.IsEmpty() && mHeap.Top().mDeadline <= nowMillis)
+		mRegistry.ArmAt(mHandle, nowMillis + 1);
+	else
+		Rearm();
+	return delivered;
+}
+
+void DelayedQueue::OnDue(void* context_, TimerRegistry::Handle)
+{
+	static_cast<DelayedQueue*>(context_)->Drain();
+}
+
+uint16_t DelayedQueue::SlotOf(MessageId message_) const
+{
+	const uint16_t slot = static_cast<uint16_t>(message_ & 0xFFFF);
+	if (slot >= mCapacity || mSlots[slot].mGeneration != message_ >> 16
+		|| (SLOT_QUEUED != mSlots[slot].mState && SLOT_DUE != mSlots[slot].mState))
+		return INVALID_SLOT;
+	return slot;
+}
+
+void DelayedQueue::Release(uint16_t slot_)
+{
+	Slot& message = mSlots[slot_];
+	++message.mGeneration;
+	message.mState = SLOT_FREE;
+	message.mNext = mFreeSlot;
+	mFreeSlot = slot_;
+}
+
+void DelayedQueue::Rearm()
+{
+	if (mHeap.IsEmpty())
+		mRegistry.Cancel(mHandle);
+	else
+		mRegistry.ArmAt(mHandle, mHeap.Top().mDeadline);
+}
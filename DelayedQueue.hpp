@@ -0,0 +1,182 @@
+/**
+ * 	DelayedQueue class.
+ *
+ * 	"Deliver this event with its payload in 250 ms" without a Timer plus a
+ * 	struct per call site that all have to be polled. Messages (a type and up
+ * 	to PAYLOAD_SIZE bytes) are copied into a fixed arena of equal slots and
+ * 	indexed by deadline in a DeadlineHeap:
+ * 		- PostAt() / PostAfter() take a free slot in O(1) and insert it into
+ * 			the heap in O(log n);
+ * 		- Cancel() removes it from the heap in O(log n);
+ * 		- Drain() delivers everything due in deadline order against a
+ * 			single clock reading.
+ * 	One TimerRegistry entry is kept armed for the earliest deadline, so
+ * 	Dispatch() drains the queue exactly when something is due.
+ *
+ * There are a few things to keep in mind:
+ * 		- Storage is passed in by the owner. StaticDelayedQueue<N, P> bundles
+ * 			the storage for N messages of up to P bytes each.
+ * 		- Message ids carry a generation, so cancelling a message that has
+ * 			already been delivered (and whose slot is reused) does nothing.
+ * 		- Messages with the same deadline are delivered in no particular order.
+ * 		- The handler may post and cancel. A drain first takes all messages
+ * 			due at its clock reading out of the heap, then delivers them, so
+ * 			messages posted by the handler (even "for now") wait for the next
+ * 			drain, which runs on a later Dispatch() (1 ms later at the
+ * 			earliest). Cancelling one of the taken messages still works.
+ * 		- The payload passed to the handler is valid during the call only.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "DeadlineHeap.hpp"
+#include "TimerRegistry.hpp"
+
+class DelayedQueue {
+
+public:
+
+	using MessageId = uint32_t;
+
+	//	Returned by PostAt() / PostAfter() if the queue is full or the payload too long.
+	static constexpr MessageId INVALID_MESSAGE = 0xFFFFFFFFu;
+
+	using Handler = void (*)(void* context_, uint16_t type_, const uint8_t* payload_, uint16_t length_);
+
+	struct Slot {
+		uint16_t mType;
+		uint16_t mLength;
+		uint16_t mGeneration;
+		//	Next slot on the free list or, during a drain, on the list of due messages.
+		uint16_t mNext;
+		uint8_t mState;
+	};
+
+	/**
+	 * Storage pointers, capacity elements each (mArena: capacity * payload size bytes).
+	 */
+	struct Storage {
+		Slot* mSlots;
+		uint8_t* mArena;
+		DeadlineHeap::Node* mNodes;
+		uint16_t* mPositions;
+	};
+
+	struct Stats {
+		uint32_t mPosted{0};
+		uint32_t mDelivered{0};
+		uint32_t mCancelled{0};
+		//	Posts refused, queue full or payload too long.
+		uint32_t mRejected{0};
+		uint16_t mPeakQueued{0};
+		//	Delivery time minus deadline.
+		uint32_t mMaxLatenessMillis{0};
+	};
+
+	/**
+	 * @brief Creates an empty queue. Prefer StaticDelayedQueue<N, P>.
+	 */
+	DelayedQueue(TimerRegistry& registry_, const Storage& storage_, uint16_t capacity_, uint16_t payloadSize_,
+					Handler handler_, void* context_);
+	~DelayedQueue();
+
+	DelayedQueue(const DelayedQueue&) = delete;
+	DelayedQueue& operator=(const DelayedQueue&) = delete;
+
+	/**
+	 * @brief Queues a message for delivery at deadlineMillis_ (registry clock).
+	 *
+	 * @return The id of the message (for Cancel()), INVALID_MESSAGE if refused.
+	 */
+	MessageId PostAt(uint64_t deadlineMillis_, uint16_t type_, const void* payload_ = nullptr, uint16_t length_ = 0);
+
+	/**
+	 * @brief Queues a message for delivery delayMillis_ from now. See PostAt().
+	 */
+	MessageId PostAfter(uint32_t delayMillis_, uint16_t type_, const void* payload_ = nullptr, uint16_t length_ = 0);
+
+	/**
+	 * @brief Removes a queued message.
+	 *
+	 * @return False if it was not queued (anymore).
+	 */
+	bool Cancel(MessageId message_);
+
+	auto IsQueued(MessageId message_) const -> bool {return INVALID_SLOT != SlotOf(message_);}
+
+	/**
+	 * @brief Delivers the messages due (called by Dispatch() via the registry).
+	 *
+	 * @return The number of messages delivered.
+	 */
+	uint16_t Drain();
+
+	auto QueuedCount() const -> uint16_t {return mHeap.Size();}
+	auto GetCapacity() const -> uint16_t {return mCapacity;}
+	auto GetPayloadSize() const -> uint16_t {return mPayloadSize;}
+	auto GetStats() const -> const Stats& {return mStats;}
+
+
+private:
+
+	static constexpr uint16_t INVALID_SLOT = DeadlineHeap::INVALID_ID;
+
+	//	Slot states: free (or being delivered), in the heap, taken by a drain, cancelled after that.
+	static constexpr uint8_t SLOT_FREE = 0;
+	static constexpr uint8_t SLOT_QUEUED = 1;
+	static constexpr uint8_t SLOT_DUE = 2;
+	static constexpr uint8_t SLOT_CANCELLED = 3;
+
+	static void OnDue(void* context_, TimerRegistry::Handle handle_);
+
+	//	Returns the slot of a queued message, INVALID_SLOT if not queued.
+	uint16_t SlotOf(MessageId message_) const;
+	void Release(uint16_t slot_);
+	//	Arms the registry entry for the earliest deadline.
+	void Rearm();
+
+	TimerRegistry& mRegistry;
+	Slot* mSlots;
+	uint8_t* mArena;
+	DeadlineHeap mHeap;
+	uint16_t mCapacity;
+	uint16_t mPayloadSize;
+	Handler mHandler;
+	void* mContext;
+	TimerRegistry::Handle mHandle;
+
+	uint16_t mFreeSlot{0};
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticDelayedQueue, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY, uint16_t PAYLOAD_SIZE>
+struct DelayedQueueStorage {
+	DelayedQueue::Slot mSlotStorage[CAPACITY];
+	uint8_t mArenaStorage[CAPACITY * PAYLOAD_SIZE];
+	DeadlineHeap::Node mNodeStorage[CAPACITY];
+	uint16_t mPositionStorage[CAPACITY];
+};
+
+/**
+ * 	DelayedQueue with built-in storage for CAPACITY messages of up to PAYLOAD_SIZE bytes.
+ */
+template <uint16_t CAPACITY, uint16_t PAYLOAD_SIZE>
+class StaticDelayedQueue : private DelayedQueueStorage<CAPACITY, PAYLOAD_SIZE>, public DelayedQueue {
+
+public:
+
+	StaticDelayedQueue(TimerRegistry& registry_, Handler handler_, void* context_) :
+		DelayedQueue(registry_,
+						{this->mSlotStorage, this->mArenaStorage, this->mNodeStorage, this->mPositionStorage},
+						CAPACITY, PAYLOAD_SIZE, handler_, context_)
+	{
+	}
+
+};
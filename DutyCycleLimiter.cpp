@@ -0,0 +1,167 @@
+#include "DutyCycleLimiter.hpp"
+
+DutyCycleLimiter::DutyCycleLimiter(TimerRegistry& registry_, Transmission* ring_, uint16_t capacity_,
+									uint32_t windowMillis_, uint16_t dutyCyclePermille_,
+									ReadyCallback ready_, void* context_) :
+	mRegistry(registry_),
+	mRing(ring_),
+	mCapacity(capacity_),
+	mWindowMillis(windowMillis_),
+	mBudgetMillis(capacity_ > 0 ? static_cast<uint32_t>(static_cast<uint64_t>(windowMillis_) * dutyCyclePermille_ / 1000) : 0),
+	mReady(ready_),
+	mContext(context_),
+	mHandle(registry_.Add(OnReady, this))
+{
+}
+
+DutyCycleLimiter::~DutyCycleLimiter()
+{
+	mRegistry.Remove(mHandle);
+}
+
+void DutyCycleLimiter::Record(uint64_t startMillis_, uint32_t airtimeMillis_)
+{
+	if (0 == mCapacity)
+		return;
+
+	Prune(static_cast<uint32_t>(mRegistry.Now()) - mWindowMillis);
+	const uint32_t startMillis = static_cast<uint32_t>(startMillis_);
+
+	if (mCount == mCapacity)
+	{
+		//	Merge into the newest entry, placing the airtime at the end of both.
+		Transmission& newest = At(static_cast<uint16_t>(mCount - 1));
+		const uint32_t newestEnd = newest.mStartMillis + newest.mAirtimeMillis;
+		const uint32_t end = static_cast<int32_t>(startMillis + airtimeMillis_ - newestEnd) > 0
+								? startMillis + airtimeMillis_ : newestEnd;
+		newest.mAirtimeMillis += airtimeMillis_;
+		newest.mStartMillis = end - newest.mAirtimeMillis;
+		++mStats.mMerged;
+	}
+	else
+	{
+		At(mCount) = Transmission{startMillis, airtimeMillis_};
+		++mCount;
+	}
+
+	mTotalMillis += airtimeMillis_;
+	++mStats.mTransmissions;
+	mStats.mAirtimeMillis += airtimeMillis_;
+}
+
+uint32_t DutyCycleLimiter::GetUsedMillis()
+{
+	return Prune(static_cast<uint32_t>(mRegistry.Now()) - mWindowMillis);
+}
+
+uint64_t DutyCycleLimiter::EarliestTransmit(uint32_t airtimeMillis_)
+{
+	if (airtimeMillis_ > mBudgetMillis)
+		return NEVER;
+
+	const uint64_t nowMillis = mRegistry.Now();
+	Prune(static_cast<uint32_t>(nowMillis) - mWindowMillis);
+
+	//	Window ending with the transmission, if it started now.
+	const uint32_t firstStartMillis = static_cast<uint32_t>(nowMillis) + airtimeMillis_ - mWindowMillis;
+	uint32_t windowStartMillis = firstStartMillis;
+
+	uint64_t usedMillis = mTotalMillis;
+	for (uint16_t offset = 0; offset < mCount; ++offset)
+	{
+		const Transmission& transmission = At(offset);
+		if (static_cast<int32_t>(windowStartMillis - transmission.mStartMillis) <= 0)
+			break;
+		const uint32_t beforeMillis = windowStartMillis - transmission.mStartMillis;
+		usedMillis -= beforeMillis < transmission.mAirtimeMillis ? beforeMillis : transmission.mAirtimeMillis;
+	}
+
+	const uint32_t allowedMillis = mBudgetMillis - airtimeMillis_;
+	if (usedMillis <= allowedMillis)
+		return nowMillis;
+
+	//	Slide the window forward until enough of the oldest airtime has left it.
+	uint64_t excessMillis = usedMillis - allowedMillis;
+	for (uint16_t offset = 0; offset < mCount && excessMillis > 0; ++offset)
+	{
+		const Transmission& transmission = At(offset);
+		const uint32_t endMillis = transmission.mStartMillis + transmission.mAirtimeMillis;
+		if (static_cast<int32_t>(endMillis - windowStartMillis) <= 0)
+			continue;
+
+		const uint32_t fromMillis = static_cast<int32_t>(transmission.mStartMillis - windowStartMillis) > 0
+									? transmission.mStartMillis : windowStartMillis;
+		const uint32_t portionMillis = endMillis - fromMillis;
+		if (portionMillis >= excessMillis)
+		{
+			windowStartMillis = fromMillis + static_cast<uint32_t>(excessMillis);
+			excessMillis = 0;
+		}
+		else
+		{
+			windowStartMillis = endMillis;
+			excessMillis -= portionMillis;
+		}
+	}
+	return nowMillis + (windowStartMillis - firstStartMillis);
+}
+
+bool DutyCycleLimiter::AwaitTransmit(uint32_t airtimeMillis_)
+{
+	const uint64_t readyMillis = EarliestTransmit(airtimeMillis_);
+	if (NEVER == readyMillis)
+		return false;
+
+	if (readyMillis > mRegistry.Now())
+		++mStats.mDeferred;
+	mAwaitedMillis = airtimeMillis_;
+	mRegistry.ArmAt(mHandle, readyMillis);
+	return true;
+}
+
+void DutyCycleLimiter::CancelAwait()
+{
+	mRegistry.Cancel(mHandle);
+}
+
+void DutyCycleLimiter::OnReady(void* context_, TimerRegistry::Handle)
+{
+	DutyCycleLimiter& limiter = *static_cast<DutyCycleLimiter*>(context_);
+
+	//	Transmissions recorded meanwhile may have moved the time.
+	const uint64_t readyMillis = limiter.EarliestTransmit(limiter.mAwaitedMillis);
+	if (NEVER == readyMillis)
+		return;
+	if (readyMillis > limiter.mRegistry.Now())
+	{
+		limiter.mRegistry.ArmAt(limiter.mHandle, readyMillis);
+		return;
+	}
+	if (limiter.mReady)
+		limiter.mReady(limiter.mContext, limiter.mAwaitedMillis);
+}
+
+uint32_t DutyCycleLimiter::Prune(uint32_t windowStartMillis_)
+{
+	while (mCount > 0)
+	{
+		const Transmission& oldest = At(0);
+		if (static_cast<int32_t>(oldest.mStartMillis + oldest.mAirtimeMillis - windowStartMillis_) > 0)
+			break;
+		mTotalMillis -= oldest.mAirtimeMillis;
+		mHead = static_cast<uint16_t>((mHead + 1) % mCapacity);
+		--mCount;
+	}
+
+	//	Entries straddling the window start count with their part inside only.
+	uint64_t usedMillis = mTotalMillis;
+	for (uint16_t offset = 0; offset < mCount; ++offset)
+	{
+		const Transmission& transmission = At(offset);
+		if (static_cast<int32_t>(windowStartMillis_ - transmission.mStartMillis) <= 0)
+			break;
+		const uint32_t beforeMillis = windowStartMillis_ - transmission.mStartMillis;
+		usedMillis -= beforeMillis < transmission.mAirtimeMillis ? beforeMillis : transmission.mAirtimeMillis;
+	}
+	return static_cast<uint32_t>(usedMillis);
+}
@@ -0,0 +1,161 @@
+/**
+ * 	DutyCycleLimiter class.
+ *
+ * 	Keeps radio transmissions within a regulatory duty cycle (f.e. 1 %)
+ * 	over a rolling window (f.e. one hour). A Timer reset every hour allows
+ * 	bursts of twice the budget around the reset; here every point in time
+ * 	is checked against the window ending there.
+ *
+ * 	Transmissions are recorded as (start, airtime) in a ring on the
+ * 	registry clock, together with a running total of the airtime in it.
+ * 	Entries are dropped as they leave the window, each once, so:
+ * 		- GetUsedMillis() is O(1) amortized;
+ * 		- EarliestTransmit() ("when may I send X ms?") is O(1) if the budget
+ * 			allows sending now, otherwise it walks the oldest entries that
+ * 			have to leave the window first.
+ * 	AwaitTransmit() arms a TimerRegistry entry for that time and calls back
+ * 	when the transmission may start, so nothing needs to be polled.
+ *
+ * There are a few things to keep in mind:
+ * 		- The check is made at the end of the planned transmission: the
+ * 			airtime in the window ending there, including the transmission,
+ * 			must not exceed the budget.
+ * 		- If the ring is full, a new transmission is merged into the newest
+ * 			entry. The merged airtime is placed at the end of the span, so it
+ * 			leaves the window later than it really does - never too early.
+ * 		- Times are kept as the low 32 bits of the registry clock, so the
+ * 			window must be shorter than 24 days.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class DutyCycleLimiter {
+
+public:
+
+	static constexpr uint32_t HOUR_MILLIS = 3600000;
+
+	//	Returned by EarliestTransmit() if the airtime exceeds the whole budget.
+	static constexpr uint64_t NEVER = TimerRegistry::NO_DEADLINE;
+
+	//	Called when the transmission awaited with AwaitTransmit() may start.
+	using ReadyCallback = void (*)(void* context_, uint32_t airtimeMillis_);
+
+	struct Transmission {
+		uint32_t mStartMillis;
+		uint32_t mAirtimeMillis;
+	};
+
+	struct Stats {
+		uint32_t mTransmissions{0};
+		uint64_t mAirtimeMillis{0};
+		//	Transmissions merged into the newest entry because the ring was full.
+		uint32_t mMerged{0};
+		//	AwaitTransmit() calls that had to wait.
+		uint32_t mDeferred{0};
+	};
+
+	/**
+	 * @brief Creates a limiter on the passed ring. Prefer StaticDutyCycleLimiter<N>.
+	 * 		Without a ring (capacity_ 0) no airtime can be accounted for, so the
+	 * 		budget is 0: nothing may be sent.
+	 *
+	 * @param dutyCyclePermille_: Share of the window that may be spent transmitting (10 = 1 %).
+	 */
+	DutyCycleLimiter(TimerRegistry& registry_, Transmission* ring_, uint16_t capacity_,
+						uint32_t windowMillis_, uint16_t dutyCyclePermille_,
+						ReadyCallback ready_ = nullptr, void* context_ = nullptr);
+	~DutyCycleLimiter();
+
+	DutyCycleLimiter(const DutyCycleLimiter&) = delete;
+	DutyCycleLimiter& operator=(const DutyCycleLimiter&) = delete;
+
+	/**
+	 * @brief Records a transmission. Record them in order of their start.
+	 * 		Ignored without a ring.
+	 */
+	void Record(uint64_t startMillis_, uint32_t airtimeMillis_);
+
+	/**
+	 * @brief Returns the airtime spent in the window ending now.
+	 */
+	uint32_t GetUsedMillis();
+
+	/**
+	 * @brief Returns the earliest point in time (registry clock, >= now) a
+	 * 		transmission of airtimeMillis_ may start, NEVER if it exceeds the budget.
+	 */
+	uint64_t EarliestTransmit(uint32_t airtimeMillis_);
+
+	/**
+	 * @brief Calls back the ready callback once a transmission of airtimeMillis_
+	 * 		may start. Replaces an earlier request.
+	 *
+	 * @return False if the airtime exceeds the budget.
+	 */
+	bool AwaitTransmit(uint32_t airtimeMillis_);
+	void CancelAwait();
+
+	auto GetBudgetMillis() const -> uint32_t {return mBudgetMillis;}
+	auto GetWindowMillis() const -> uint32_t {return mWindowMillis;}
+	auto GetStats() const -> const Stats& {return mStats;}
+
+
+private:
+
+	static void OnReady(void* context_, TimerRegistry::Handle handle_);
+
+	auto At(uint16_t offset_) -> Transmission& {return mRing[(mHead + offset_) % mCapacity];}
+
+	//	Drops entries that ended before windowStartMillis_; returns the airtime after it.
+	uint32_t Prune(uint32_t windowStartMillis_);
+
+	TimerRegistry& mRegistry;
+	Transmission* mRing;
+	uint16_t mCapacity;
+	uint32_t mWindowMillis;
+	uint32_t mBudgetMillis;
+	ReadyCallback mReady;
+	void* mContext;
+	TimerRegistry::Handle mHandle;
+
+	uint16_t mHead{0};
+	uint16_t mCount{0};
+	//	Airtime of all entries in the ring.
+	uint64_t mTotalMillis{0};
+	uint32_t mAwaitedMillis{0};
+
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticDutyCycleLimiter, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct DutyCycleLimiterStorage {
+	DutyCycleLimiter::Transmission mRingStorage[CAPACITY];
+};
+
+/**
+ * 	DutyCycleLimiter remembering up to CAPACITY transmissions.
+ */
+template <uint16_t CAPACITY>
+class StaticDutyCycleLimiter : private DutyCycleLimiterStorage<CAPACITY>, public DutyCycleLimiter {
+
+	static_assert(CAPACITY > 0, "A DutyCycleLimiter needs at least one ring entry");
+
+public:
+
+	StaticDutyCycleLimiter(TimerRegistry& registry_, uint32_t windowMillis_, uint16_t dutyCyclePermille_,
+							ReadyCallback ready_ = nullptr, void* context_ = nullptr) :
+		DutyCycleLimiter(registry_, this->mRingStorage, CAPACITY, windowMillis_, dutyCyclePermille_, ready_, context_)
+	{
+	}
+
+};
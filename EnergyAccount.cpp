@@ -0,0 +1,99 @@
+#include "EnergyAccount.hpp"
+
+#include "Timer.hpp"
+
+namespace {
+
+	constexpr uint64_t MICROS_PER_HOUR = 3600ull * 1000 * 1000;
+
+}
+
+EnergyAccount::EnergyAccount(const TimerRegistry* registry_) :
+	mRegistry(registry_)
+{
+	Reset();
+}
+
+void EnergyAccount::RecordSleep(uint64_t sleptMicros_)
+{
+	mSleepMicros += sleptMicros_;
+}
+
+void EnergyAccount::RecordWakeup(uint32_t awakeMicros_)
+{
+	uint32_t expiries = 0;
+	if (mRegistry)
+	{
+		//	After ResetStats() the counter starts over below the last reading.
+		const uint32_t fired = mRegistry->GetStats().mFired;
+		expiries = fired >= mLastFired ? fired - mLastFired : fired;
+		mLastFired = fired;
+	}
+	RecordWakeup(awakeMicros_, expiries);
+}
+
+void EnergyAccount::RecordWakeup(uint32_t awakeMicros_, uint32_t expiries_)
+{
+	++mWakeupCount;
+	mExpiryCount += expiries_;
+	mAwakeMicros += awakeMicros_;
+}
+
+void EnergyAccount::RecordAwake(uint32_t awakeMicros_)
+{
+	mAwakeMicros += awakeMicros_;
+}
+
+void EnergyAccount::Reset()
+{
+	mLastFired = mRegistry ? mRegistry->GetStats().mFired : 0;
+	mWakeupCount = 0;
+	mExpiryCount = 0;
+	mAwakeMicros = 0;
+	mSleepMicros = 0;
+}
+
+uint32_t EnergyAccount::GetWakeupsPerHour() const
+{
+	const uint64_t elapsedMicros = GetElapsedMicros();
+	if (0 == elapsedMicros)
+		return 0;
+	return NarrowConvertToUint32(static_cast<uint64_t>(mWakeupCount) * MICROS_PER_HOUR / elapsedMicros);
+}
+
+uint32_t EnergyAccount::GetMeanAwakeMicrosPerWakeup() const
+{
+	return mWakeupCount > 0 ? NarrowConvertToUint32(mAwakeMicros / mWakeupCount) : 0;
+}
+
+uint32_t EnergyAccount::GetExpiriesPerWakeupCentis() const
+{
+	return mWakeupCount > 0 ? NarrowConvertToUint32(static_cast<uint64_t>(mExpiryCount) * 100 / mWakeupCount) : 0;
+}
+
+uint32_t EnergyAccount::GetAverageMicroamps(const EnergyModel& model_) const
+{
+	return NarrowConvertToUint32(static_cast<uint64_t>(AverageMicroamps(model_) + 0.5));
+}
+
+float EnergyAccount::EstimateMilliampHoursPerDay(const EnergyModel& model_) const
+{
+	return static_cast<float>(AverageMicroamps(model_) * 24.0 / 1000.0);
+}
+
+double EnergyAccount::AverageMicroamps(const EnergyModel& model_) const
+{
+	const uint64_t elapsedMicros = GetElapsedMicros();
+	if (0 == elapsedMicros)
+		return 0.0;
+
+	//	The wakeup overhead is spent awake instead of asleep.
+	const uint64_t overheadMicros = static_cast<uint64_t>(mWakeupCount) * model_.mWakeupOverheadMicros;
+	const uint64_t awakeMicros = mAwakeMicros + (overheadMicros < mSleepMicros ? overheadMicros : mSleepMicros);
+	const uint64_t sleepMicros = elapsedMicros - awakeMicros;
+
+	//	In double: microamps times microseconds overflows 64 bits after a few days.
+	const double charge = static_cast<double>(awakeMicros) * model_.mAwakeMicroamps
+							+ static_cast<double>(sleepMicros) * model_.mSleepMicroamps;
+	return charge / static_cast<double>(elapsedMicros);
+}
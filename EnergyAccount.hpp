@@ -0,0 +1,117 @@
+/**
+ * 	EnergyAccount class.
+ *
+ * 	Accounts how often the CPU wakes up and how long it stays awake, for
+ * 	battery budgeting. A sleeping backend (LoopPacer, VirtualTimeSimulator)
+ * 	reports each stretch of sleep with RecordSleep() and each stretch of
+ * 	work after waking with RecordWakeup(). From that the account derives
+ * 	wakeups per hour, awake time per wakeup and - if bound to a registry -
+ * 	timer expiries per wakeup.
+ *
+ * 	An EnergyModel (currents of both states plus a fixed cost per wakeup)
+ * 	then turns the account into an average current and an estimate of the
+ * 	charge drawn per day. Comparing the estimate of two timer
+ * 	configurations run in the VirtualTimeSimulator shows what f.e.
+ * 	coalescing deadlines saves, without a battery on the bench.
+ *
+ * There are a few things to keep in mind:
+ * 		- The account only knows what it was told. Time not reported as
+ * 			sleep or wakeup is not part of the elapsed time.
+ * 		- Expiries are taken from the registry's fire counter: the expiries
+ * 			since the previous wakeup are credited to the current one.
+ * 		- The model is linear and ignores f.e. peripherals or radio. It is
+ * 			meant for comparing configurations, not for exact predictions.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class EnergyAccount {
+
+public:
+
+	struct EnergyModel {
+		//	Current while sleeping.
+		uint32_t mSleepMicroamps;
+		//	Current while awake.
+		uint32_t mAwakeMicroamps;
+		//	Extra time at awake current per wakeup (f.e. clock and PLL start-up).
+		uint32_t mWakeupOverheadMicros;
+	};
+
+	/**
+	 * @brief Creates an empty account.
+	 *
+	 * @param registry_: Registry to take expiries from (optional).
+	 */
+	explicit EnergyAccount(const TimerRegistry* registry_ = nullptr);
+
+	/**
+	 * @brief Reports a stretch of sleep.
+	 */
+	void RecordSleep(uint64_t sleptMicros_);
+
+	/**
+	 * @brief Reports a wakeup followed by awakeMicros_ of work.
+	 * 		Expiries are taken from the registry (if any).
+	 */
+	void RecordWakeup(uint32_t awakeMicros_);
+
+	/**
+	 * @brief Reports a wakeup that handled expiries_ timer expiries.
+	 */
+	void RecordWakeup(uint32_t awakeMicros_, uint32_t expiries_);
+
+	/**
+	 * @brief Reports awakeMicros_ of work without a wakeup (the CPU did not
+	 * 		sleep since the last report). Expiries go to the next wakeup.
+	 */
+	void RecordAwake(uint32_t awakeMicros_);
+
+	/**
+	 * @brief Clears all counters.
+	 */
+	void Reset();
+
+
+	auto GetWakeupCount() const -> uint32_t {return mWakeupCount;}
+	auto GetExpiryCount() const -> uint32_t {return mExpiryCount;}
+	auto GetAwakeMicros() const -> uint64_t {return mAwakeMicros;}
+	auto GetSleepMicros() const -> uint64_t {return mSleepMicros;}
+	auto GetElapsedMicros() const -> uint64_t {return mAwakeMicros + mSleepMicros;}
+
+	uint32_t GetWakeupsPerHour() const;
+	uint32_t GetMeanAwakeMicrosPerWakeup() const;
+
+	/**
+	 * @brief Returns the expiries per wakeup, in hundredths (150 = 1.5).
+	 */
+	uint32_t GetExpiriesPerWakeupCentis() const;
+
+	/**
+	 * @brief Returns the average current over the elapsed time under model_.
+	 */
+	uint32_t GetAverageMicroamps(const EnergyModel& model_) const;
+
+	/**
+	 * @brief Returns the charge drawn per day under model_, in mAh.
+	 */
+	float EstimateMilliampHoursPerDay(const EnergyModel& model_) const;
+
+
+private:
+
+	double AverageMicroamps(const EnergyModel& model_) const;
+
+	const TimerRegistry* mRegistry;
+	uint32_t mLastFired{0};
+
+	uint32_t mWakeupCount{0};
+	uint32_t mExpiryCount{0};
+	uint64_t mAwakeMicros{0};
+	uint64_t mSleepMicros{0};
+
+};
@@ -0,0 +1,41 @@
+#include "FrameRing.hpp"
+
+FrameRing::FrameRing(uint8_t* storage_, size_t frameSize_, uint16_t frameCount_) :
+	mStorage(storage_),
+	mFrameSize(frameSize_),
+	mFrameCount(frameCount_)
+{
+}
+
+uint8_t* FrameRing::BeginWrite()
+{
+	if (IsFull())
+		return nullptr;
+	const uint16_t tail = static_cast<uint16_t>((mHead + mCount) % mFrameCount);
+	return mStorage + static_cast<size_t>(tail) * mFrameSize;
+}
+
+void FrameRing::CommitWrite()
+{
+	if (!IsFull())
+		++mCount;
+}
+
+const uint8_t* FrameRing::Peek(uint16_t index_) const
+{
+	if (index_ >= mCount)
+		return nullptr;
+	const uint16_t frame = static_cast<uint16_t>((mHead + index_) % mFrameCount);
+	return mStorage + static_cast<size_t>(frame) * mFrameSize;
+}
+
+void FrameRing::Release(uint16_t count_)
+{
+	if (count_ > mCount)
+		count_ = mCount;
+	//	Nothing to release; also keeps a ring without frames away from % 0.
+	if (0 == count_)
+		return;
+	mHead = static_cast<uint16_t>((mHead + count_) % mFrameCount);
+	mCount = static_cast<uint16_t>(mCount - count_);
+}
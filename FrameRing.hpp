@@ -0,0 +1,86 @@
+/**
+ * 	FrameRing class.
+ *
+ * 	A single producer / single consumer ring of fixed-size frames on storage
+ * 	passed in by the owner. Frames are written and read in place: the
+ * 	producer fills the frame returned by BeginWrite() and commits it, the
+ * 	consumer reads frames via Peek() and releases them - no copies.
+ * 	A ring of two frames is a classic double buffer.
+ *
+ * 	Not synchronized: producer and consumer must run on the same core / task
+ * 	(f.e. both from TimerRegistry callbacks).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class FrameRing {
+
+public:
+
+	/**
+	 * @param storage_: frameSize_ * frameCount_ bytes.
+	 * @param frameCount_: Not 0; a ring without frames is both full and empty.
+	 */
+	FrameRing(uint8_t* storage_, size_t frameSize_, uint16_t frameCount_);
+
+	/**
+	 * @brief Returns the next free frame to fill, nullptr if the ring is full.
+	 * 		The frame becomes readable with CommitWrite().
+	 */
+	uint8_t* BeginWrite();
+	void CommitWrite();
+
+	/**
+	 * @brief Returns the index_-th oldest readable frame, nullptr if there is none.
+	 */
+	const uint8_t* Peek(uint16_t index_ = 0) const;
+
+	/**
+	 * @brief Releases the count_ oldest frames for writing again.
+	 */
+	void Release(uint16_t count_ = 1);
+
+	auto GetDepth() const -> uint16_t {return mCount;}
+	auto GetFrameCount() const -> uint16_t {return mFrameCount;}
+	auto GetFrameSize() const -> size_t {return mFrameSize;}
+	auto IsFull() const -> bool {return mCount == mFrameCount;}
+	auto IsEmpty() const -> bool {return 0 == mCount;}
+
+
+private:
+
+	uint8_t* mStorage;
+	size_t mFrameSize;
+	uint16_t mFrameCount;
+	uint16_t mHead{0};
+	uint16_t mCount{0};
+
+};
+
+
+/**
+ * 	Storage for StaticFrameRing, see TimerRegistryStorage.
+ */
+template <size_t FRAME_SIZE, uint16_t FRAME_COUNT>
+struct FrameRingStorage {
+	uint8_t mFrameStorage[FRAME_SIZE * FRAME_COUNT];
+};
+
+/**
+ * 	FrameRing with built-in storage for FRAME_COUNT frames of FRAME_SIZE bytes.
+ */
+template <size_t FRAME_SIZE, uint16_t FRAME_COUNT>
+class StaticFrameRing : private FrameRingStorage<FRAME_SIZE, FRAME_COUNT>, public FrameRing {
+
+	static_assert(FRAME_COUNT > 0, "A FrameRing needs at least one frame");
+
+public:
+
+	StaticFrameRing() :
+		FrameRing(this->mFrameStorage, FRAME_SIZE, FRAME_COUNT)
+	{
+	}
+
+};
@@ -0,0 +1,214 @@
+#include "LoadGovernor.hpp"
+
+#include "Timer.hpp"
+
+LoadGovernor::LoadGovernor(TimerRegistry& registry_, Adaptive* adaptives_, uint16_t capacity_, const Config& config_) :
+	mRegistry(registry_),
+	mAdaptives(adaptives_),
+	mCapacity(capacity_),
+	mConfig(config_),
+	mEvaluationHandle(registry_.Add(OnEvaluate, this))
+{
+}
+
+LoadGovernor::~LoadGovernor()
+{
+	mRegistry.Remove(mEvaluationHandle);
+}
+
+bool LoadGovernor::Add(TimerRegistry::Handle handle_, uint32_t minPeriodMillis_, uint32_t maxPeriodMillis_, uint8_t priority_)
+{
+	//	Only periodic entries, each once; a zero period would make it one-shot.
+	if (mCount >= mCapacity || !mRegistry.IsValid(handle_) || 0 == mRegistry.PeriodOf(handle_) || 0 == minPeriodMillis_)
+		return false;
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		if (mAdaptives[index].mHandle == handle_)
+			return false;
+	}
+
+	const uint32_t maxPeriodMillis = maxPeriodMillis_ > minPeriodMillis_ ? maxPeriodMillis_ : minPeriodMillis_;
+	mAdaptives[mCount++] = Adaptive{handle_, mRegistry.CallbackOf(handle_), mRegistry.ContextOf(handle_),
+									minPeriodMillis_, maxPeriodMillis, minPeriodMillis_, priority_};
+	mRegistry.SetPeriod(handle_, minPeriodMillis_);
+	return true;
+}
+
+void LoadGovernor::Remove(TimerRegistry::Handle handle_)
+{
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		if (mAdaptives[index].mHandle != handle_)
+			continue;
+
+		if (!IsStale(mAdaptives[index]))
+			Apply(mAdaptives[index], mAdaptives[index].mMinPeriodMillis);
+		else if (mAdaptives[index].mPeriodMillis > mAdaptives[index].mMinPeriodMillis)
+			--mTelemetry.mStretchedEntries;
+		mAdaptives[index] = mAdaptives[--mCount];
+		return;
+	}
+}
+
+void LoadGovernor::Start()
+{
+	const TimerRegistry::Stats& stats = mRegistry.GetStats();
+	mLastFired = stats.mFired;
+	mLastLatenessSumMillis = stats.mLatenessSumMillis;
+	mRegistry.ArmAfter(mEvaluationHandle, mConfig.mEvaluationMillis, mConfig.mEvaluationMillis);
+}
+
+void LoadGovernor::Stop()
+{
+	mRegistry.Cancel(mEvaluationHandle);
+}
+
+void LoadGovernor::ReportUtilization(uint8_t percent_)
+{
+	mUtilizationPercent = percent_;
+	mUtilizationReported = true;
+}
+
+void LoadGovernor::SetObserver(Observer observer_, void* context_)
+{
+	mObserver = observer_;
+	mObserverContext = context_;
+}
+
+void LoadGovernor::Evaluate()
+{
+	const TimerRegistry::Stats& stats = mRegistry.GetStats();
+	//	ResetStats() since the last evaluation: count from the reset.
+	if (stats.mFired < mLastFired || stats.mLatenessSumMillis < mLastLatenessSumMillis)
+	{
+		mLastFired = 0;
+		mLastLatenessSumMillis = 0;
+	}
+	const uint32_t fired = stats.mFired - mLastFired;
+	const uint64_t latenessSumMillis = stats.mLatenessSumMillis - mLastLatenessSumMillis;
+	mLastFired = stats.mFired;
+	mLastLatenessSumMillis = stats.mLatenessSumMillis;
+
+	const uint32_t meanLatenessMillis = fired > 0 ? NarrowConvertToUint32(latenessSumMillis / fired) : 0;
+	++mTelemetry.mEvaluations;
+	mTelemetry.mLastMeanLatenessMillis = meanLatenessMillis;
+	mTelemetry.mLastUtilizationPercent = mUtilizationPercent;
+
+	const bool tooLate = meanLatenessMillis > mConfig.mMaxMeanLatenessMillis;
+	const bool tooBusy = mUtilizationReported && mUtilizationPercent > mConfig.mHighUtilizationPercent;
+	const bool relaxed = meanLatenessMillis <= mConfig.mMaxMeanLatenessMillis / 2
+						&& (!mUtilizationReported || mUtilizationPercent < mConfig.mLowUtilizationPercent);
+	mUtilizationReported = false;
+
+	DropStale();
+	if (tooLate || tooBusy)
+	{
+		++mTelemetry.mOverloadedEvaluations;
+		StretchLeastImportant();
+	}
+	else if (relaxed)
+		ShrinkMostImportant();
+}
+
+uint32_t LoadGovernor::GetPeriod(TimerRegistry::Handle handle_) const
+{
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		if (mAdaptives[index].mHandle == handle_)
+			return mAdaptives[index].mPeriodMillis;
+	}
+	return 0;
+}
+
+void LoadGovernor::OnEvaluate(void* context_, TimerRegistry::Handle)
+{
+	static_cast<LoadGovernor*>(context_)->Evaluate();
+}
+
+void LoadGovernor::DropStale()
+{
+	for (uint16_t index = 0; index < mCount;)
+	{
+		//	Removed from the registry (and maybe reused) without Remove() here: not ours to touch.
+		const Adaptive& adaptive = mAdaptives[index];
+		if (!IsStale(adaptive))
+		{
+			++index;
+			continue;
+		}
+		if (adaptive.mPeriodMillis > adaptive.mMinPeriodMillis)
+			--mTelemetry.mStretchedEntries;
+		mAdaptives[index] = mAdaptives[--mCount];
+	}
+}
+
+bool LoadGovernor::StretchLeastImportant()
+{
+	//	Find the least important class (highest number) with room left.
+	int16_t priority = -1;
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		const Adaptive& adaptive = mAdaptives[index];
+		if (adaptive.mPriority > 0 && adaptive.mPeriodMillis < adaptive.mMaxPeriodMillis && adaptive.mPriority > priority)
+			priority = adaptive.mPriority;
+	}
+	if (priority < 0)
+		return false;
+
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		Adaptive& adaptive = mAdaptives[index];
+		if (adaptive.mPriority != priority)
+			continue;
+		const uint64_t doubled = static_cast<uint64_t>(adaptive.mPeriodMillis > 0 ? adaptive.mPeriodMillis : 1) * 2;
+		Apply(adaptive, doubled < adaptive.mMaxPeriodMillis ? static_cast<uint32_t>(doubled) : adaptive.mMaxPeriodMillis);
+	}
+	return true;
+}
+
+bool LoadGovernor::ShrinkMostImportant()
+{
+	//	Find the most important class (lowest number) that runs stretched.
+	int16_t priority = 0x100;
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		const Adaptive& adaptive = mAdaptives[index];
+		if (adaptive.mPeriodMillis > adaptive.mMinPeriodMillis && adaptive.mPriority < priority)
+			priority = adaptive.mPriority;
+	}
+	if (priority > 0xFF)
+		return false;
+
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		Adaptive& adaptive = mAdaptives[index];
+		if (adaptive.mPriority != priority)
+			continue;
+		const uint32_t halved = adaptive.mPeriodMillis / 2;
+		Apply(adaptive, halved > adaptive.mMinPeriodMillis ? halved : adaptive.mMinPeriodMillis);
+	}
+	return true;
+}
+
+void LoadGovernor::Apply(Adaptive& adaptive_, uint32_t periodMillis_)
+{
+	const uint32_t oldPeriodMillis = adaptive_.mPeriodMillis;
+	if (oldPeriodMillis == periodMillis_)
+		return;
+
+	const bool wasStretched = oldPeriodMillis > adaptive_.mMinPeriodMillis;
+	const bool isStretched = periodMillis_ > adaptive_.mMinPeriodMillis;
+	if (isStretched && !wasStretched)
+		++mTelemetry.mStretchedEntries;
+	else if (!isStretched && wasStretched)
+		--mTelemetry.mStretchedEntries;
+	if (periodMillis_ > oldPeriodMillis)
+		++mTelemetry.mStretches;
+	else
+		++mTelemetry.mShrinks;
+
+	adaptive_.mPeriodMillis = periodMillis_;
+	mRegistry.SetPeriod(adaptive_.mHandle, periodMillis_);
+	if (mObserver)
+		mObserver(mObserverContext, adaptive_.mHandle, oldPeriodMillis, periodMillis_);
+}
@@ -0,0 +1,178 @@
+/**
+ * 	LoadGovernor class.
+ *
+ * 	When the loop is overloaded, every periodic entry still demands its full
+ * 	rate, so everything gets late together. The governor lets periodic
+ * 	TimerRegistry entries declare a minimum and maximum period and a
+ * 	priority. It evaluates the load at a fixed interval:
+ * 		- overloaded (utilization above the high mark or mean lateness above
+ * 			the limit): the periods of the least important priority class that
+ * 			is not yet at its maximum are doubled (up to the maximum).
+ * 		- headroom (utilization below the low mark and lateness below half
+ * 			the limit): the periods of the most important stretched class are
+ * 			halved again (down to the minimum).
+ * 	One class per evaluation, so the load settles in small steps, and the
+ * 	gap between the two marks avoids oscillation.
+ *
+ * 	Lateness is taken from the registry's statistics. Utilization is not
+ * 	measured by the registry; report it with ReportUtilization() (f.e. from
+ * 	LoopPacer::GetUtilizationPercent()). Without reports, only lateness counts.
+ *
+ * There are a few things to keep in mind:
+ * 		- Priority 0 is the most important. Entries with priority 0 are never
+ * 			stretched.
+ * 		- A new period applies from the next expiry of the entry on.
+ * 		- Every adjustment is counted and can be observed via SetObserver().
+ * 		- Remove() entries from the governor before removing them from the
+ * 			registry. An entry removed from the registry first is dropped on
+ * 			the next evaluation: the governor remembers callback and context
+ * 			of every entry, so it never adjusts a reused handle.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class LoadGovernor {
+
+public:
+
+	struct Config {
+		uint32_t mEvaluationMillis{1000};
+		uint8_t mHighUtilizationPercent{85};
+		uint8_t mLowUtilizationPercent{60};
+		uint32_t mMaxMeanLatenessMillis{5};
+	};
+
+	struct Adaptive {
+		TimerRegistry::Handle mHandle;
+		//	Identify the registry entry; a reused handle has others.
+		TimerRegistry::Callback mCallback;
+		void* mContext;
+		uint32_t mMinPeriodMillis;
+		uint32_t mMaxPeriodMillis;
+		uint32_t mPeriodMillis;
+		uint8_t mPriority;
+	};
+
+	struct Telemetry {
+		uint32_t mEvaluations{0};
+		uint32_t mOverloadedEvaluations{0};
+		uint32_t mStretches{0};
+		uint32_t mShrinks{0};
+		uint32_t mLastMeanLatenessMillis{0};
+		uint8_t mLastUtilizationPercent{0};
+		//	Entries currently running above their minimum period.
+		uint16_t mStretchedEntries{0};
+	};
+
+	using Observer = void (*)(void* context_, TimerRegistry::Handle handle_, uint32_t oldPeriodMillis_, uint32_t newPeriodMillis_);
+
+	/**
+	 * @brief Creates a governor on the passed storage. Prefer StaticLoadGovernor<N>.
+	 */
+	LoadGovernor(TimerRegistry& registry_, Adaptive* adaptives_, uint16_t capacity_, const Config& config_);
+	~LoadGovernor();
+
+	LoadGovernor(const LoadGovernor&) = delete;
+	LoadGovernor& operator=(const LoadGovernor&) = delete;
+
+	/**
+	 * @brief Puts a periodic registry entry under control. Its period is
+	 * 		set to minPeriodMillis_ right away.
+	 *
+	 * @return False if the governor is full, the entry is not periodic, already
+	 * 		controlled or minPeriodMillis_ is 0.
+	 */
+	bool Add(TimerRegistry::Handle handle_, uint32_t minPeriodMillis_, uint32_t maxPeriodMillis_, uint8_t priority_);
+
+	/**
+	 * @brief Releases the entry from control and restores its minimum period.
+	 */
+	void Remove(TimerRegistry::Handle handle_);
+
+	/**
+	 * @brief Starts / stops the periodic evaluation.
+	 */
+	void Start();
+	void Stop();
+
+	/**
+	 * @brief Reports the current loop utilization, used by the next evaluation.
+	 */
+	void ReportUtilization(uint8_t percent_);
+
+	/**
+	 * @brief Evaluates the load and adjusts one priority class (called periodically after Start()).
+	 */
+	void Evaluate();
+
+	/**
+	 * @brief Called on every period adjustment (nullptr = off).
+	 */
+	void SetObserver(Observer observer_, void* context_);
+
+	auto GetTelemetry() const -> const Telemetry& {return mTelemetry;}
+
+	/**
+	 * @brief Returns the current period of a controlled entry, 0 if not controlled.
+	 */
+	uint32_t GetPeriod(TimerRegistry::Handle handle_) const;
+
+
+private:
+
+	static void OnEvaluate(void* context_, TimerRegistry::Handle handle_);
+
+	auto IsStale(const Adaptive& adaptive_) const -> bool
+	{
+		return mRegistry.CallbackOf(adaptive_.mHandle) != adaptive_.mCallback
+				|| mRegistry.ContextOf(adaptive_.mHandle) != adaptive_.mContext;
+	}
+	void DropStale();
+	bool StretchLeastImportant();
+	bool ShrinkMostImportant();
+	void Apply(Adaptive& adaptive_, uint32_t periodMillis_);
+
+	TimerRegistry& mRegistry;
+	Adaptive* mAdaptives;
+	uint16_t mCapacity;
+	uint16_t mCount{0};
+	Config mConfig;
+	TimerRegistry::Handle mEvaluationHandle;
+	Observer mObserver{nullptr};
+	void* mObserverContext{nullptr};
+
+	uint8_t mUtilizationPercent{0};
+	bool mUtilizationReported{false};
+	uint32_t mLastFired{0};
+	uint64_t mLastLatenessSumMillis{0};
+	Telemetry mTelemetry;
+
+};
+
+
+/**
+ * 	Storage for StaticLoadGovernor, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct LoadGovernorStorage {
+	LoadGovernor::Adaptive mAdaptiveStorage[CAPACITY];
+};
+
+/**
+ * 	LoadGovernor with built-in storage for CAPACITY entries.
+ */
+template <uint16_t CAPACITY>
+class StaticLoadGovernor : private LoadGovernorStorage<CAPACITY>, public LoadGovernor {
+
+public:
+
+	StaticLoadGovernor(TimerRegistry& registry_, const Config& config_ = Config{}) :
+		LoadGovernor(registry_, this->mAdaptiveStorage, CAPACITY, config_)
+	{
+	}
+
+};
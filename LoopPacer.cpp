@@ -0,0 +1,112 @@
+#include "LoopPacer.hpp"
+
+LoopPacer::LoopPacer(uint32_t periodMicros_) :
+	mPeriodMicros(periodMicros_ > MIN_PERIOD_MICROS ? periodMicros_ : MIN_PERIOD_MICROS)
+{
+	Restart();
+}
+
+bool LoopPacer::SetPeriod(uint32_t periodMicros_)
+{
+	if (periodMicros_ < MIN_PERIOD_MICROS)
+		return false;
+	mPeriodMicros = periodMicros_;
+	return true;
+}
+
+void LoopPacer::SetEnergyAccount(EnergyAccount* account_)
+{
+	mAccount = account_;
+	mWokenUpMicros = micros();
+	mSlept = true;
+}
+
+void LoopPacer::Restart()
+{
+	mFrameStartMicros = micros();
+	mNextFrameMicros = mFrameStartMicros + mPeriodMicros;
+}
+
+bool LoopPacer::WaitForNextFrame()
+{
+	const uint32_t nowMicros = micros();
+	mStats.mLastBusyMicros = nowMicros - mFrameStartMicros;
+	++mStats.mFrameCount;
+
+	//	Signed difference, so the comparison survives the micros() wrap.
+	const int32_t lateMicros = static_cast<int32_t>(nowMicros - mNextFrameMicros);
+	if (lateMicros > 0)
+	{
+		const uint32_t overrunMicros = static_cast<uint32_t>(lateMicros);
+		++mStats.mOverrunCount;
+		mStats.mTotalOverrunMicros += overrunMicros;
+		if (overrunMicros > mStats.mMaxOverrunMicros)
+			mStats.mMaxOverrunMicros = overrunMicros;
+
+		//	Start this frame late, but keep the grid: skip frames missed entirely.
+		const uint32_t missedFrames = overrunMicros / mPeriodMicros;
+		mStats.mSkippedFrameCount += missedFrames;
+		mFrameStartMicros = mNextFrameMicros + missedFrames * mPeriodMicros;
+		mNextFrameMicros = mFrameStartMicros + mPeriodMicros;
+		mPublishedStats.Write(mStats);
+		ReportFrame(nowMicros, 0);
+		return false;
+	}
+	mPublishedStats.Write(mStats);
+
+	if (mRunner)
+	{
+		//	Keep one millisecond in reserve for the sleep granularity.
+		const uint32_t leftoverMillis = static_cast<uint32_t>(-lateMicros) / 1000;
+		if (leftoverMillis > 1)
+			mRunner->Run(leftoverMillis - 1);
+	}
+
+	SleepUntil(mNextFrameMicros);
+	mFrameStartMicros = mNextFrameMicros;
+	mNextFrameMicros += mPeriodMicros;
+	return true;
+}
+
+uint16_t LoopPacer::GetUtilizationPercent() const
+{
+	if (0 == mPeriodMicros)
+		return 0;
+	const uint64_t percent = static_cast<uint64_t>(mStats.mLastBusyMicros) * 100 / mPeriodMicros;
+	return percent > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(percent);
+}
+
+void LoopPacer::SleepUntil(uint32_t targetMicros_)
+{
+	const uint32_t sleepStartMicros = micros();
+	const int32_t remainingMicros = static_cast<int32_t>(targetMicros_ - sleepStartMicros);
+
+	//	delay() may oversleep up to one tick, so only whole milliseconds minus one.
+	uint32_t sleptMicros = 0;
+	if (remainingMicros > 2000)
+	{
+		delay(static_cast<uint32_t>(remainingMicros) / 1000 - 1);
+		sleptMicros = micros() - sleepStartMicros;
+	}
+	ReportFrame(sleepStartMicros, sleptMicros);
+
+	while (static_cast<int32_t>(targetMicros_ - micros()) > 0)
+		yield();
+}
+
+void LoopPacer::ReportFrame(uint32_t sleepStartMicros_, uint32_t sleptMicros_)
+{
+	if (!mAccount)
+		return;
+
+	//	Time since the last sleep ended was spent awake; a wakeup only if there was a sleep.
+	const uint32_t awakeMicros = sleepStartMicros_ - mWokenUpMicros;
+	if (mSlept)
+		mAccount->RecordWakeup(awakeMicros);
+	else
+		mAccount->RecordAwake(awakeMicros);
+	if (sleptMicros_ > 0)
+		mAccount->RecordSleep(sleptMicros_);
+	mSlept = sleptMicros_ > 0;
+	mWokenUpMicros = sleepStartMicros_ + sleptMicros_;
+}
@@ -0,0 +1,139 @@
+/**
+ * 	LoopPacer class.
+ *
+ * 	Lets loop() run at a fixed cadence (f.e. 1 kHz or 100 Hz) instead of
+ * 	spinning. WaitForNextFrame() is called once per loop() pass and returns
+ * 	at the start of the next frame.
+ *
+ * 	Frames are placed on absolute deadlines (like vTaskDelayUntil()): the
+ * 	next frame starts exactly one period after the previous frame's start,
+ * 	no matter when WaitForNextFrame() was called. So the cadence does not
+ * 	drift - unlike a Timer, which restarts from the observed time.
+ *
+ * There are a few things to keep in mind:
+ * 		- The pacer works in microseconds, so it is exact for short periods.
+ * 			The period is limited to ~35 minutes (signed compare of uint32_t
+ * 			micros) and must not be zero; a zero period is taken as 1 us.
+ * 		- While waiting, whole milliseconds are slept with delay() (which
+ * 			yields to other tasks on ESP32 / ESP8266), only the rest is spent
+ * 			in a yield()ing wait.
+ * 		- If a pass took longer than a frame, that is counted as overrun and
+ * 			the next frame starts immediately. If whole frames were missed,
+ * 			they are skipped (and counted) rather than run back to back.
+ * 		- Optionally, leftover frame time is handed to a BackgroundRunner
+ * 			before sleeping.
+ * 		- The getters are for the task running the loop. Other tasks / cores
+ * 			read the counters with ReadPublishedStats(), published every frame.
+ * 		- Optionally, every frame is reported to an EnergyAccount: delay() as
+ * 			sleep, everything else (work, background jobs, the yield()ing
+ * 			wait) as time awake. A frame after a delay() counts as wakeup;
+ * 			frames too short to sleep (f.e. at 1 kHz) only add awake time.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "BackgroundRunner.hpp"
+#include "EnergyAccount.hpp"
+#include "Seqlock.hpp"
+
+class LoopPacer {
+
+public:
+
+	static constexpr uint32_t MIN_PERIOD_MICROS = 1;
+
+	struct Stats {
+		uint32_t mFrameCount{0};
+		uint32_t mOverrunCount{0};
+		uint32_t mSkippedFrameCount{0};
+		uint64_t mTotalOverrunMicros{0};
+		uint32_t mMaxOverrunMicros{0};
+		uint32_t mLastBusyMicros{0};
+	};
+
+	/**
+	 * @brief Creates a pacer. The first frame starts on creation.
+	 *
+	 * @param periodMicros_: Frame period in microseconds (f.e. 1000 for 1 kHz), 0 is taken as 1.
+	 */
+	explicit LoopPacer(uint32_t periodMicros_);
+
+	/**
+	 * @brief Hands leftover frame time to runner_ before sleeping (nullptr = off).
+	 */
+	auto SetBackgroundRunner(BackgroundRunner* runner_) -> void {mRunner = runner_;}
+
+	/**
+	 * @brief Reports sleeps and wakeups to account_ (nullptr = off).
+	 */
+	void SetEnergyAccount(EnergyAccount* account_);
+
+	/**
+	 * @brief Changes the period. Takes effect from the next frame on.
+	 *
+	 * @return False (period unchanged) if periodMicros_ is 0.
+	 */
+	bool SetPeriod(uint32_t periodMicros_);
+	auto GetPeriod() const -> uint32_t {return mPeriodMicros;}
+
+	/**
+	 * @brief Starts over: the next frame begins one period from now.
+	 * 		Statistics are kept.
+	 */
+	void Restart();
+
+	/**
+	 * @brief Waits for the start of the next frame.
+	 *
+	 * @return False if the current frame was overrun (did not wait).
+	 */
+	bool WaitForNextFrame();
+
+
+	auto GetFrameCount() const -> uint32_t {return mStats.mFrameCount;}
+	auto GetOverrunCount() const -> uint32_t {return mStats.mOverrunCount;}
+	auto GetSkippedFrameCount() const -> uint32_t {return mStats.mSkippedFrameCount;}
+	auto GetTotalOverrunMicros() const -> uint64_t {return mStats.mTotalOverrunMicros;}
+	auto GetMaxOverrunMicros() const -> uint32_t {return mStats.mMaxOverrunMicros;}
+
+	/**
+	 * @brief Copies the counters as of the last WaitForNextFrame().
+	 * 		Safe from any task / core, see TimerRegistry::ReadPublishedStats().
+	 */
+	auto ReadPublishedStats(Stats& stats_) const -> bool {return mPublishedStats.Read(stats_);}
+
+	/**
+	 * @brief Returns the time the last pass spent before calling
+	 * 		WaitForNextFrame() (i.e. the loop's own work).
+	 */
+	auto GetLastBusyMicros() const -> uint32_t {return mStats.mLastBusyMicros;}
+
+	/**
+	 * @brief Returns the share of the last frame spent busy, in percent
+	 * 		(may exceed 100 on overruns).
+	 */
+	uint16_t GetUtilizationPercent() const;
+
+
+private:
+
+	void SleepUntil(uint32_t targetMicros_);
+
+	//	Reports the frame up to sleepStartMicros_ as awake and sleptMicros_ as sleep.
+	void ReportFrame(uint32_t sleepStartMicros_, uint32_t sleptMicros_);
+
+	BackgroundRunner* mRunner{nullptr};
+	EnergyAccount* mAccount{nullptr};
+	uint32_t mWokenUpMicros{0};
+	//	The last reported frame slept, so the next one starts with a wakeup.
+	bool mSlept{true};
+	uint32_t mPeriodMicros;
+	uint32_t mFrameStartMicros;
+	uint32_t mNextFrameMicros;
+
+	Stats mStats;
+	Seqlock<Stats> mPublishedStats;
+
+};
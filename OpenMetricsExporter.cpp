@@ -0,0 +1,156 @@
+#include "OpenMetricsExporter.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+	//	Lines of each phase before the per-entry / per-bucket lines: TYPE and HELP.
+	constexpr uint16_t HEADER_LINES = 2;
+
+}
+
+OpenMetricsExporter::OpenMetricsExporter(const TimerRegistry& registry_) :
+	mRegistry(registry_)
+{
+}
+
+void OpenMetricsExporter::Begin()
+{
+	mStats = mRegistry.GetStats();
+	mPhase = PHASE_FIRES;
+	mIndex = 0;
+}
+
+size_t OpenMetricsExporter::Render(char* buffer_, size_t size_)
+{
+	size_t used = 0;
+	char line[LINE_SIZE];
+	while (mPhase != PHASE_DONE)
+	{
+		//	A line truncated by snprintf() would be invalid (and length points past it): skip it.
+		const int length = FormatLine(line, sizeof(line));
+		if (length > 0 && static_cast<size_t>(length) < sizeof(line))
+		{
+			if (used + static_cast<size_t>(length) > size_)
+				break;
+			memcpy(buffer_ + used, line, static_cast<size_t>(length));
+			used += static_cast<size_t>(length);
+		}
+		Advance();
+	}
+	return used;
+}
+
+int OpenMetricsExporter::FormatLine(char* line_, size_t size_) const
+{
+	switch (mPhase)
+	{
+	case PHASE_FIRES:
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_fires counter\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_fires Expiries called back by the registry.\n");
+		return snprintf(line_, size_, "timer_fires_total %lu\n", static_cast<unsigned long>(mStats.mFired));
+
+	case PHASE_MISSED:
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_missed_periods counter\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_missed_periods Periods skipped because they passed completely.\n");
+		return snprintf(line_, size_, "timer_missed_periods_total %lu\n", static_cast<unsigned long>(mStats.mMissedPeriods));
+
+	case PHASE_LATENESS:
+	{
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_lateness_milliseconds histogram\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_lateness_milliseconds Time between deadline and callback.\n");
+
+		const uint32_t bucket = mIndex - HEADER_LINES;
+		if (bucket < TimerRegistry::LATENESS_BUCKET_COUNT)
+		{
+			unsigned long cumulative = 0;
+			for (uint32_t lower = 0; lower <= bucket; ++lower)
+				cumulative += mStats.mLatenessBuckets[lower];
+			if (bucket + 1 == TimerRegistry::LATENESS_BUCKET_COUNT)
+				return snprintf(line_, size_, "timer_lateness_milliseconds_bucket{le=\"+Inf\"} %lu\n", cumulative);
+			return snprintf(line_, size_, "timer_lateness_milliseconds_bucket{le=\"%lu\"} %lu\n",
+							static_cast<unsigned long>(TimerRegistry::LATENESS_BUCKET_BOUNDS[bucket]), cumulative);
+		}
+		if (bucket == TimerRegistry::LATENESS_BUCKET_COUNT)
+			return snprintf(line_, size_, "timer_lateness_milliseconds_sum %llu\n",
+							static_cast<unsigned long long>(mStats.mLatenessSumMillis));
+		return snprintf(line_, size_, "timer_lateness_milliseconds_count %lu\n", static_cast<unsigned long>(mStats.mFired));
+	}
+
+	case PHASE_MAX_LATENESS:
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_max_lateness_milliseconds gauge\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_max_lateness_milliseconds Largest lateness seen.\n");
+		return snprintf(line_, size_, "timer_max_lateness_milliseconds %lu\n", static_cast<unsigned long>(mStats.mMaxLatenessMillis));
+
+	case PHASE_ENTRIES:
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_entries gauge\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_entries Registry entries by state.\n");
+		if (2 == mIndex)
+			return snprintf(line_, size_, "timer_entries{state=\"armed\"} %u\n", static_cast<unsigned>(mRegistry.ArmedCount()));
+		return snprintf(line_, size_, "timer_entries{state=\"allocated\"} %u\n", static_cast<unsigned>(mRegistry.AllocatedCount()));
+
+	case PHASE_ENTRY_FIRES:
+	{
+		if (0 == mIndex)
+			return snprintf(line_, size_, "# TYPE timer_entry_fires counter\n");
+		if (1 == mIndex)
+			return snprintf(line_, size_, "# HELP timer_entry_fires Expiries per registry entry.\n");
+
+		const TimerRegistry::Handle handle = static_cast<TimerRegistry::Handle>(mIndex - HEADER_LINES);
+		if (!mRegistry.IsValid(handle))
+			return 0;
+		return snprintf(line_, size_, "timer_entry_fires_total{handle=\"%u\"} %lu\n",
+						static_cast<unsigned>(handle), static_cast<unsigned long>(mRegistry.FireCountOf(handle)));
+	}
+
+	case PHASE_EOF:
+		return snprintf(line_, size_, "# EOF\n");
+
+	case PHASE_DONE:
+		break;
+	}
+	return 0;
+}
+
+void OpenMetricsExporter::Advance()
+{
+	uint32_t lines = 0;
+	switch (mPhase)
+	{
+	case PHASE_FIRES:
+	case PHASE_MISSED:
+	case PHASE_MAX_LATENESS:
+		lines = HEADER_LINES + 1;
+		break;
+	case PHASE_LATENESS:
+		lines = HEADER_LINES + TimerRegistry::LATENESS_BUCKET_COUNT + 2;
+		break;
+	case PHASE_ENTRIES:
+		lines = HEADER_LINES + 2;
+		break;
+	case PHASE_ENTRY_FIRES:
+		lines = HEADER_LINES + static_cast<uint32_t>(mRegistry.Capacity());
+		break;
+	case PHASE_EOF:
+		lines = 1;
+		break;
+	case PHASE_DONE:
+		return;
+	}
+
+	if (++mIndex < lines)
+		return;
+	mIndex = 0;
+	mPhase = static_cast<Phase>(mPhase + 1);
+}
@@ -0,0 +1,82 @@
+/**
+ * 	OpenMetricsExporter class.
+ *
+ * 	Renders the metrics of a TimerRegistry as OpenMetrics (Prometheus) text
+ * 	into a buffer of the caller, f.e. to serve a scrape endpoint on the
+ * 	Linux gateway build:
+ * 		- timer_fires_total, timer_missed_periods_total
+ * 		- timer_lateness_milliseconds (histogram), timer_max_lateness_milliseconds
+ * 		- timer_entries{state="armed"|"allocated"}
+ * 		- timer_entry_fires_total{handle="n"} per allocated entry
+ *
+ * 	Rendering is incremental: Begin() takes a copy of the registry-wide
+ * 	statistics, then every Render() call fills the buffer with as many
+ * 	complete lines as fit and continues where the last call stopped. So a
+ * 	large registry can be exported a few lines per loop() pass, f.e. into
+ * 	a small socket buffer. Nothing is allocated.
+ *
+ * There are a few things to keep in mind:
+ * 		- Per entry lines are read from the registry while rendering. Call
+ * 			Render() from the task calling Dispatch(); entries changed in
+ * 			between show their state at the time their line is rendered.
+ * 		- A single line is at most LINE_SIZE bytes. A buffer smaller than
+ * 			that never makes progress.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class OpenMetricsExporter {
+
+public:
+
+	static constexpr size_t LINE_SIZE = 96;
+
+	explicit OpenMetricsExporter(const TimerRegistry& registry_);
+
+	/**
+	 * @brief Starts a new rendering pass on the current statistics.
+	 */
+	void Begin();
+
+	/**
+	 * @brief Renders the next lines into buffer_. Not zero terminated.
+	 *
+	 * @return The number of bytes written. 0 once the pass is done - or, if
+	 * 		IsDone() is still false, because the next line does not fit
+	 * 		into size_ (a buffer of LINE_SIZE bytes always fits a line).
+	 */
+	size_t Render(char* buffer_, size_t size_);
+
+	/**
+	 * @brief Returns true once Render() has written all lines of the pass.
+	 */
+	auto IsDone() const -> bool {return PHASE_DONE == mPhase;}
+
+
+private:
+
+	enum Phase : uint8_t {
+		PHASE_FIRES,
+		PHASE_MISSED,
+		PHASE_LATENESS,
+		PHASE_MAX_LATENESS,
+		PHASE_ENTRIES,
+		PHASE_ENTRY_FIRES,
+		PHASE_EOF,
+		PHASE_DONE
+	};
+
+	//	Formats the current line into line_; returns its length, 0 to skip it.
+	int FormatLine(char* line_, size_t size_) const;
+	void Advance();
+
+	const TimerRegistry& mRegistry;
+	TimerRegistry::Stats mStats;
+	Phase mPhase{PHASE_DONE};
+	uint32_t mIndex{0};
+
+};
@@ -0,0 +1,196 @@
+#include "OperatingHours.hpp"
+
+namespace {
+
+	constexpr uint32_t CRC_INITIAL = 0xFFFFFFFFu;
+	constexpr uint32_t CRC_POLYNOMIAL = 0xEDB88320u;	// CRC-32, reflected
+
+	uint32_t UpdateCrc(uint32_t crc_, const void* data_, size_t length_)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data_);
+		for (size_t index = 0; index < length_; ++index)
+		{
+			crc_ ^= bytes[index];
+			for (uint8_t bit = 0; bit < 8; ++bit)
+				crc_ = (crc_ >> 1) ^ (CRC_POLYNOMIAL & (0u - (crc_ & 1u)));
+		}
+		return crc_;
+	}
+
+}
+
+OperatingHours::OperatingHours(TimerRegistry& registry_, const Flash& flash_, Channel* channels_, uint16_t channelCount_,
+								uint32_t checkpointMillis_) :
+	mRegistry(registry_),
+	mFlash(flash_),
+	mChannels(channels_),
+	mChannelCount(channelCount_),
+	mCheckpointMillis(checkpointMillis_),
+	mRecordSize(static_cast<uint32_t>(sizeof(Header) + channelCount_ * sizeof(uint64_t) + sizeof(Trailer))),
+	mSlotsPerSector(flash_.mSectorSize / mRecordSize),
+	mHandle(registry_.Add(OnCheckpoint, this))
+{
+	for (uint16_t channel = 0; channel < mChannelCount; ++channel)
+		mChannels[channel] = Channel{0, 0, false};
+}
+
+OperatingHours::~OperatingHours()
+{
+	mRegistry.Remove(mHandle);
+}
+
+bool OperatingHours::Begin()
+{
+	const uint32_t sequence = mStats.mSequence;
+	bool found = false;
+	uint32_t newestSlot = 0;
+	Header header;
+	for (uint32_t slot = 0; slot < SlotCount(); ++slot)
+	{
+		if (!ReadRecord(slot, header))
+			continue;
+		if (!found || static_cast<int32_t>(header.mSequence - mStats.mSequence) > 0)
+		{
+			found = true;
+			newestSlot = slot;
+			mStats.mSequence = header.mSequence;
+		}
+	}
+
+	if (found)
+	{
+		const uint32_t address = AddressOf(newestSlot) + sizeof(Header);
+		for (uint16_t channel = 0; channel < mChannelCount; ++channel)
+		{
+			uint64_t totalMillis;
+			if (!mFlash.mRead(mFlash.mContext, address + channel * sizeof(uint64_t), &totalMillis, sizeof(totalMillis)))
+			{
+				//	Back to the state before Begin(). No checkpoints either: they would
+				//	replace the newest record with incomplete totals.
+				for (uint16_t restored = 0; restored < channel; ++restored)
+					mChannels[restored].mTotalMillis = 0;
+				mStats.mSequence = sequence;
+				++mStats.mFailures;
+				return false;
+			}
+			mChannels[channel].mTotalMillis = totalMillis;
+		}
+		mNextSlot = (newestSlot / mSlotsPerSector + 1) % mFlash.mSectorCount * mSlotsPerSector;
+	}
+
+	mRegistry.ArmAfter(mHandle, mCheckpointMillis, mCheckpointMillis);
+	return found;
+}
+
+void OperatingHours::Set(uint16_t channel_, bool on_)
+{
+	if (channel_ >= mChannelCount || mChannels[channel_].mOn == on_)
+		return;
+
+	Channel& channel = mChannels[channel_];
+	const uint64_t nowMillis = mRegistry.Now();
+	if (channel.mOn)
+	{
+		channel.mTotalMillis += nowMillis - channel.mSinceMillis;
+		mDirty = true;
+	}
+	channel.mSinceMillis = nowMillis;
+	channel.mOn = on_;
+}
+
+uint64_t OperatingHours::GetTotalMillis(uint16_t channel_) const
+{
+	if (channel_ >= mChannelCount)
+		return 0;
+
+	const Channel& channel = mChannels[channel_];
+	return channel.mTotalMillis + (channel.mOn ? mRegistry.Now() - channel.mSinceMillis : 0);
+}
+
+bool OperatingHours::Checkpoint()
+{
+	if (0 == mSlotsPerSector || mFlash.mSectorCount < 2)
+		return false;
+
+	//	Fold the running spans in, so the record holds everything up to now.
+	const uint64_t nowMillis = mRegistry.Now();
+	for (uint16_t channel = 0; channel < mChannelCount; ++channel)
+	{
+		Channel& current = mChannels[channel];
+		if (!current.mOn || nowMillis == current.mSinceMillis)
+			continue;
+		current.mTotalMillis += nowMillis - current.mSinceMillis;
+		current.mSinceMillis = nowMillis;
+		mDirty = true;
+	}
+
+	++mStats.mCheckpoints;
+	if (!mDirty)
+	{
+		++mStats.mSkipped;
+		return true;
+	}
+
+	const uint32_t slot = mNextSlot;
+	if (0 == slot % mSlotsPerSector)
+	{
+		++mStats.mErases;
+		if (!mFlash.mErase(mFlash.mContext, static_cast<uint16_t>(slot / mSlotsPerSector)))
+		{
+			++mStats.mFailures;
+			return false;
+		}
+	}
+	mNextSlot = (slot + 1) % SlotCount();
+
+	//	The CRC goes last, so a torn write leaves an invalid record.
+	const Header header{RECORD_MAGIC, mChannelCount, mStats.mSequence + 1};
+	uint32_t address = AddressOf(slot);
+	uint32_t crc = UpdateCrc(CRC_INITIAL, &header, sizeof(header));
+	bool written = mFlash.mWrite(mFlash.mContext, address, &header, sizeof(header));
+	address += sizeof(header);
+	for (uint16_t channel = 0; channel < mChannelCount && written; ++channel)
+	{
+		const uint64_t totalMillis = mChannels[channel].mTotalMillis;
+		crc = UpdateCrc(crc, &totalMillis, sizeof(totalMillis));
+		written = mFlash.mWrite(mFlash.mContext, address, &totalMillis, sizeof(totalMillis));
+		address += sizeof(totalMillis);
+	}
+	const Trailer trailer{~crc, 0xFFFFFFFFu};
+	if (!written || !mFlash.mWrite(mFlash.mContext, address, &trailer, sizeof(trailer)))
+	{
+		++mStats.mFailures;
+		return false;
+	}
+
+	mStats.mSequence = header.mSequence;
+	mDirty = false;
+	return true;
+}
+
+void OperatingHours::OnCheckpoint(void* context_, TimerRegistry::Handle)
+{
+	static_cast<OperatingHours*>(context_)->Checkpoint();
+}
+
+bool OperatingHours::ReadRecord(uint32_t slot_, Header& header_) const
+{
+	uint32_t address = AddressOf(slot_);
+	if (!mFlash.mRead(mFlash.mContext, address, &header_, sizeof(header_))
+		|| header_.mMagic != RECORD_MAGIC || header_.mChannelCount != mChannelCount)
+		return false;
+
+	uint32_t crc = UpdateCrc(CRC_INITIAL, &header_, sizeof(header_));
+	address += sizeof(header_);
+	for (uint16_t channel = 0; channel < mChannelCount; ++channel)
+	{
+		uint64_t totalMillis;
+		if (!mFlash.mRead(mFlash.mContext, address, &totalMillis, sizeof(totalMillis)))
+			return false;
+		crc = UpdateCrc(crc, &totalMillis, sizeof(totalMillis));
+		address += sizeof(totalMillis);
+	}
+
+	Trailer trailer;
+	return mFlash.mRead(mFlash.mContext, address, &trailer, sizeof(trailer)) && trailer.mCrc == ~crc;
+}
@@ -0,0 +1,184 @@
+/**
+ * 	OperatingHours class.
+ *
+ * 	Operating-hours counters (pump, compressor, heater, ...) for many
+ * 	channels. Instead of polling a Timer and adding TimePassedInMillis()
+ * 	while a relay is on, the application reports the edges with Set(); the
+ * 	time between them is added to the channel in ms, exact to the clock,
+ * 	however seldom the loop runs.
+ *
+ * 	The totals are checkpointed to flash by a periodic TimerRegistry entry
+ * 	(and by Checkpoint() f.e. on a power-fail warning), not on every change.
+ * 	A checkpoint with nothing new is skipped. Records are appended round-robin
+ * 	over all sectors of the flash area, so every sector is erased equally
+ * 	often, once per (slots per sector) checkpoints:
+ * 		header (magic, channel count, sequence), one 64 bit total per
+ * 		channel, CRC-32 over both.
+ * 	Begin() restores the valid record with the highest sequence; a torn
+ * 	write fails its CRC and the record before it is used.
+ *
+ * There are a few things to keep in mind:
+ * 		- The flash is reached through the Flash callbacks, so the same
+ * 			code runs on internal flash, an external chip or a simulated
+ * 			flash on the host. Writes are 8 byte aligned multiples of 8 bytes.
+ * 		- The area needs at least two sectors: erasing the next sector must
+ * 			not take the newest record with it.
+ * 		- The channel count is part of the layout; records written for
+ * 			another count are ignored. Reserve spare channels up front.
+ * 		- After Begin() writing continues at the next sector, as the rest of
+ * 			the current one may hold a torn write.
+ * 		- Time not checkpointed before a power loss is lost (at most one
+ * 			checkpoint period).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class OperatingHours {
+
+public:
+
+	static constexpr uint16_t RECORD_MAGIC = 0x4F48;	// "OH"
+
+	/**
+	 * Access to the flash area holding the records. Addresses are relative
+	 * to the start of the area. Each callback returns false on failure.
+	 */
+	struct Flash {
+		uint32_t mSectorSize;
+		uint16_t mSectorCount;
+		bool (*mRead)(void* context_, uint32_t address_, void* data_, size_t length_);
+		bool (*mWrite)(void* context_, uint32_t address_, const void* data_, size_t length_);
+		bool (*mErase)(void* context_, uint16_t sector_);
+		void* mContext;
+	};
+
+	struct Channel {
+		uint64_t mTotalMillis;
+		//	Start of the running span, if mOn.
+		uint64_t mSinceMillis;
+		bool mOn;
+	};
+
+	struct Stats {
+		uint32_t mCheckpoints{0};
+		//	Checkpoints with nothing new, so nothing written.
+		uint32_t mSkipped{0};
+		uint32_t mErases{0};
+		uint32_t mFailures{0};
+		//	Sequence of the newest record written or restored.
+		uint32_t mSequence{0};
+	};
+
+	/**
+	 * @brief Creates counters at zero. Prefer StaticOperatingHours<C>.
+	 *
+	 * @param checkpointMillis_: Checkpoint period after Begin().
+	 */
+	OperatingHours(TimerRegistry& registry_, const Flash& flash_, Channel* channels_, uint16_t channelCount_,
+					uint32_t checkpointMillis_);
+	~OperatingHours();
+
+	OperatingHours(const OperatingHours&) = delete;
+	OperatingHours& operator=(const OperatingHours&) = delete;
+
+	/**
+	 * @brief Restores the totals from the newest valid record and starts
+	 * 		the periodic checkpoints. Call it once, before Set().
+	 *
+	 * @return True if a record was found. False if none was found, or if
+	 * 		reading the newest one failed: then the totals stay at zero, no
+	 * 		checkpoints are started and Begin() may be called again.
+	 */
+	bool Begin();
+
+	/**
+	 * @brief Reports the condition of a channel (f.e. relay on); only the
+	 * 		edges matter, repeating the same state is cheap.
+	 */
+	void Set(uint16_t channel_, bool on_);
+
+	/**
+	 * @brief Returns the total of a channel, including the running span.
+	 */
+	uint64_t GetTotalMillis(uint16_t channel_) const;
+
+	/**
+	 * @brief Writes a record now, unless nothing changed since the last one.
+	 *
+	 * @return False if writing failed.
+	 */
+	bool Checkpoint();
+
+	auto GetChannelCount() const -> uint16_t {return mChannelCount;}
+	auto GetRecordSize() const -> uint32_t {return mRecordSize;}
+	auto GetStats() const -> const Stats& {return mStats;}
+
+
+private:
+
+	struct Header {
+		uint16_t mMagic;
+		uint16_t mChannelCount;
+		uint32_t mSequence;
+	};
+
+	struct Trailer {
+		uint32_t mCrc;
+		uint32_t mPadding;
+	};
+
+	static void OnCheckpoint(void* context_, TimerRegistry::Handle handle_);
+
+	auto SlotCount() const -> uint32_t {return mSlotsPerSector * mFlash.mSectorCount;}
+	auto AddressOf(uint32_t slot_) const -> uint32_t
+	{
+		return (slot_ / mSlotsPerSector) * mFlash.mSectorSize + (slot_ % mSlotsPerSector) * mRecordSize;
+	}
+
+	//	Returns true if the slot holds a valid record; its header goes to header_.
+	bool ReadRecord(uint32_t slot_, Header& header_) const;
+
+	TimerRegistry& mRegistry;
+	Flash mFlash;
+	Channel* mChannels;
+	uint16_t mChannelCount;
+	uint32_t mCheckpointMillis;
+	uint32_t mRecordSize;
+	uint32_t mSlotsPerSector;
+	TimerRegistry::Handle mHandle;
+
+	uint32_t mNextSlot{0};
+	//	Something changed since the last record.
+	bool mDirty{false};
+
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticOperatingHours, see TimerRegistryStorage.
+ */
+template <uint16_t CHANNELS>
+struct OperatingHoursStorage {
+	OperatingHours::Channel mChannelStorage[CHANNELS];
+};
+
+/**
+ * 	OperatingHours with built-in storage for CHANNELS channels.
+ */
+template <uint16_t CHANNELS>
+class StaticOperatingHours : private OperatingHoursStorage<CHANNELS>, public OperatingHours {
+
+public:
+
+	StaticOperatingHours(TimerRegistry& registry_, const Flash& flash_, uint32_t checkpointMillis_) :
+		OperatingHours(registry_, flash_, this->mChannelStorage, CHANNELS, checkpointMillis_)
+	{
+	}
+
+};
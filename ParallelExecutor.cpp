@@ -0,0 +1,260 @@
+#include "ParallelExecutor.hpp"
+
+#if defined(__linux__)
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+	//	Process-private futex calls; the pool lives in one process.
+	void FutexWait(std::atomic<uint32_t>& word_, uint32_t expected_)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAIT_PRIVATE, expected_, nullptr, nullptr, 0);
+	}
+
+	void FutexWake(std::atomic<uint32_t>& word_, int32_t count_)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAKE_PRIVATE, count_, nullptr, nullptr, 0);
+	}
+
+	uint64_t MonotonicMicros()
+	{
+		timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		return static_cast<uint64_t>(now.tv_sec) * 1000000 + static_cast<uint64_t>(now.tv_nsec) / 1000;
+	}
+
+}
+
+ParallelExecutor::ParallelExecutor(TimerRegistry& registry_, const Storage& storage_, uint16_t capacity_, uint8_t workerCapacity_) :
+	mRegistry(registry_),
+	mJobs(storage_.mJobs),
+	mWorkers(storage_.mWorkers),
+	mQueues(storage_.mQueues),
+	mCapacity(capacity_),
+	mWorkerCapacity(workerCapacity_)
+{
+	for (uint8_t worker = 0; worker < mWorkerCapacity; ++worker)
+		mWorkers[worker].mQueue = mQueues + static_cast<size_t>(worker) * mCapacity;
+}
+
+ParallelExecutor::~ParallelExecutor()
+{
+	Stop();
+	for (uint16_t job = 0; job < mCapacity; ++job)
+		Remove(mJobs[job].mHandle);
+}
+
+bool ParallelExecutor::Start(uint8_t workerCount_)
+{
+	if (IsRunning() || 0 == workerCount_ || workerCount_ > mWorkerCapacity)
+		return false;
+
+	mStopping.store(false);
+	mWorkerCount = workerCount_;
+	//	All deques are reset before the first worker may steal from them.
+	for (uint8_t worker = 0; worker < mWorkerCount; ++worker)
+	{
+		mWorkers[worker].mHead = 0;
+		mWorkers[worker].mCount = 0;
+	}
+	for (uint8_t worker = 0; worker < mWorkerCount; ++worker)
+		mWorkers[worker].mThread = std::thread(&ParallelExecutor::WorkerLoop, this, worker);
+	return true;
+}
+
+void ParallelExecutor::Stop()
+{
+	if (!IsRunning())
+		return;
+
+	mStopping.store(true);
+	mWorkSequence.fetch_add(1);
+	FutexWake(mWorkSequence, INT32_MAX);
+	for (uint8_t worker = 0; worker < mWorkerCount; ++worker)
+		mWorkers[worker].mThread.join();
+	mWorkerCount = 0;
+}
+
+TimerRegistry::Handle ParallelExecutor::Add(TimerRegistry::Callback callback_, void* context_)
+{
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		Job& job = mJobs[index];
+		if (job.mHandle != TimerRegistry::INVALID_HANDLE)
+			continue;
+
+		const TimerRegistry::Handle handle = mRegistry.Add(OnExpiry, &job);
+		if (TimerRegistry::INVALID_HANDLE == handle)
+			return TimerRegistry::INVALID_HANDLE;
+
+		job.mOwner = this;
+		job.mCallback = callback_;
+		job.mContext = context_;
+		job.mHandle = handle;
+		job.mState.store(JOB_IDLE);
+		return handle;
+	}
+	return TimerRegistry::INVALID_HANDLE;
+}
+
+void ParallelExecutor::Remove(TimerRegistry::Handle handle_)
+{
+	if (TimerRegistry::INVALID_HANDLE == handle_)
+		return;
+
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		Job& job = mJobs[index];
+		if (job.mHandle != handle_)
+			continue;
+
+		//	No more expiries; then wait for the run already handed to the pool.
+		mRegistry.Remove(handle_);
+		while (job.mState.load() != JOB_IDLE)
+			std::this_thread::yield();
+		job.mCallback = nullptr;
+		job.mContext = nullptr;
+		job.mHandle = TimerRegistry::INVALID_HANDLE;
+		return;
+	}
+}
+
+ParallelExecutor::Stats ParallelExecutor::GetStats() const
+{
+	Stats stats;
+	stats.mExecuted = mExecuted.load(std::memory_order_relaxed);
+	stats.mCoalesced = mCoalesced.load(std::memory_order_relaxed);
+	stats.mSteals = mSteals.load(std::memory_order_relaxed);
+	stats.mQueueDelaySumMicros = mQueueDelaySumMicros.load(std::memory_order_relaxed);
+	stats.mMaxQueueDelayMicros = mMaxQueueDelayMicros.load(std::memory_order_relaxed);
+	return stats;
+}
+
+void ParallelExecutor::OnExpiry(void* context_, TimerRegistry::Handle)
+{
+	Job& job = *static_cast<Job*>(context_);
+	ParallelExecutor& executor = *job.mOwner;
+	const uint16_t index = static_cast<uint16_t>(&job - executor.mJobs);
+
+	job.mExpiredMicros.store(MonotonicMicros(), std::memory_order_relaxed);
+	uint8_t state = job.mState.load();
+	while (true)
+	{
+		if (JOB_IDLE == state)
+		{
+			if (!job.mState.compare_exchange_weak(state, JOB_QUEUED))
+				continue;
+			//	Stopped: no pool, so run it here like a plain registry entry.
+			if (!executor.IsRunning())
+				executor.Run(index);
+			else
+				executor.Push(index);
+			return;
+		}
+		if (JOB_RUNNING == state)
+		{
+			if (!job.mState.compare_exchange_weak(state, JOB_RUNNING_AGAIN))
+				continue;
+			return;
+		}
+		//	Queued or running again: the pending run covers this expiry.
+		executor.mCoalesced.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+}
+
+void ParallelExecutor::Push(uint16_t job_)
+{
+	Worker& worker = mWorkers[mNextWorker];
+	mNextWorker = static_cast<uint8_t>((mNextWorker + 1) % mWorkerCount);
+	{
+		std::lock_guard<std::mutex> lock(worker.mMutex);
+		worker.mQueue[(worker.mHead + worker.mCount) % mCapacity] = job_;
+		++worker.mCount;
+	}
+
+	mWorkSequence.fetch_add(1);
+	if (mSleepers.load() > 0)
+		FutexWake(mWorkSequence, 1);
+}
+
+uint16_t ParallelExecutor::Take(uint8_t worker_)
+{
+	{
+		//	Oldest first, like a steal: the job queued longest has waited longest.
+		Worker& own = mWorkers[worker_];
+		std::lock_guard<std::mutex> lock(own.mMutex);
+		if (own.mCount > 0)
+		{
+			const uint16_t job = own.mQueue[own.mHead];
+			own.mHead = static_cast<uint16_t>((own.mHead + 1) % mCapacity);
+			--own.mCount;
+			return job;
+		}
+	}
+
+	for (uint8_t offset = 1; offset < mWorkerCount; ++offset)
+	{
+		Worker& victim = mWorkers[(worker_ + offset) % mWorkerCount];
+		std::lock_guard<std::mutex> lock(victim.mMutex);
+		if (0 == victim.mCount)
+			continue;
+
+		const uint16_t job = victim.mQueue[victim.mHead];
+		victim.mHead = static_cast<uint16_t>((victim.mHead + 1) % mCapacity);
+		--victim.mCount;
+		mSteals.fetch_add(1, std::memory_order_relaxed);
+		return job;
+	}
+	return DeadlineHeap::INVALID_ID;
+}
+
+void ParallelExecutor::Run(uint16_t job_)
+{
+	Job& job = mJobs[job_];
+	job.mState.store(JOB_RUNNING);
+	while (true)
+	{
+		const uint64_t delayMicros = MonotonicMicros() - job.mExpiredMicros.load(std::memory_order_relaxed);
+		const uint32_t delay = delayMicros < UINT32_MAX ? static_cast<uint32_t>(delayMicros) : UINT32_MAX;
+		mQueueDelaySumMicros.fetch_add(delay, std::memory_order_relaxed);
+		uint32_t maxDelay = mMaxQueueDelayMicros.load(std::memory_order_relaxed);
+		while (delay > maxDelay && !mMaxQueueDelayMicros.compare_exchange_weak(maxDelay, delay, std::memory_order_relaxed))
+			;
+
+		job.mCallback(job.mContext, job.mHandle);
+		mExecuted.fetch_add(1, std::memory_order_relaxed);
+
+		uint8_t state = JOB_RUNNING;
+		if (job.mState.compare_exchange_strong(state, JOB_IDLE))
+			return;
+		//	Expired again meanwhile: run once more on this worker, never in parallel.
+		job.mState.store(JOB_RUNNING);
+	}
+}
+
+void ParallelExecutor::WorkerLoop(uint8_t worker_)
+{
+	while (true)
+	{
+		const uint32_t sequence = mWorkSequence.load();
+		const uint16_t job = Take(worker_);
+		if (job != DeadlineHeap::INVALID_ID)
+		{
+			Run(job);
+			continue;
+		}
+		if (mStopping.load())
+			return;
+
+		mSleepers.fetch_add(1);
+		FutexWait(mWorkSequence, sequence);
+		mSleepers.fetch_sub(1);
+	}
+}
+
+#endif
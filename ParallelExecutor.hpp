@@ -0,0 +1,192 @@
+/**
+ * 	ParallelExecutor class (Linux only).
+ *
+ * 	On the gateway one thread dispatches the TimerRegistry, and all handlers
+ * 	run on it one after the other, so a slow handler (f.e. blocking on a
+ * 	socket) delays every unrelated timer behind it. Entries added through
+ * 	the executor do not run their handler in Dispatch(): the expiry only
+ * 	queues the handler for a pool of worker threads, and Dispatch() moves on.
+ *
+ * 	Every worker has a deque of its own. Expiries are spread round-robin;
+ * 	a worker takes the oldest job of its own deque (so jobs run in expiry
+ * 	order and none waits behind newer ones) and, when that is empty,
+ * 	steals the oldest job from another one, so a worker stuck in a slow
+ * 	handler does not hold up the jobs queued behind it. Idle workers sleep
+ * 	on a futex.
+ *
+ * 	A handler never runs concurrently with itself: every job has a state
+ * 	(idle, queued, running, running and expired again). An expiry while
+ * 	the handler runs makes the same worker run it once more afterwards.
+ *
+ * There are a few things to keep in mind:
+ * 		- Handlers run on the workers, concurrently with Dispatch() and with
+ * 			other handlers. The TimerRegistry is not thread-safe: handlers
+ * 			must not call into it; arm and cancel from the dispatch thread.
+ * 		- Expiries arriving while the handler is already queued (or queued
+ * 			to run again) are coalesced into that run and counted.
+ * 		- Remove() waits for a queued or running handler to finish.
+ * 		- Stop() lets the workers finish the queued jobs before joining them.
+ */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#include "TimerRegistry.hpp"
+
+class ParallelExecutor {
+
+public:
+
+	//	Worker deques on cache lines of their own.
+	static constexpr size_t CACHE_LINE = 64;
+
+	struct Job {
+		ParallelExecutor* mOwner{nullptr};
+		TimerRegistry::Callback mCallback{nullptr};
+		void* mContext{nullptr};
+		TimerRegistry::Handle mHandle{TimerRegistry::INVALID_HANDLE};
+		std::atomic<uint8_t> mState{0};
+		//	Time of the last expiry, for the queue delay.
+		std::atomic<uint64_t> mExpiredMicros{0};
+	};
+
+	struct alignas(CACHE_LINE) Worker {
+		std::thread mThread;
+		std::mutex mMutex;
+		//	Ring of job indices, one place per job (a job is queued once at most).
+		uint16_t* mQueue{nullptr};
+		uint16_t mHead{0};
+		uint16_t mCount{0};
+	};
+
+	/**
+	 * Storage pointers: capacity jobs, workerCapacity workers and
+	 * workerCapacity * capacity queue places.
+	 */
+	struct Storage {
+		Job* mJobs;
+		Worker* mWorkers;
+		uint16_t* mQueues;
+	};
+
+	struct Stats {
+		uint64_t mExecuted{0};
+		//	Expiries merged into a run that was already pending.
+		uint64_t mCoalesced{0};
+		//	Jobs taken from the deque of another worker.
+		uint64_t mSteals{0};
+		//	Expiry (in Dispatch()) to start of the handler.
+		uint64_t mQueueDelaySumMicros{0};
+		uint32_t mMaxQueueDelayMicros{0};
+	};
+
+	/**
+	 * @brief Creates a stopped executor. Prefer StaticParallelExecutor<J, W>.
+	 */
+	ParallelExecutor(TimerRegistry& registry_, const Storage& storage_, uint16_t capacity_, uint8_t workerCapacity_);
+	~ParallelExecutor();
+
+	ParallelExecutor(const ParallelExecutor&) = delete;
+	ParallelExecutor& operator=(const ParallelExecutor&) = delete;
+
+	/**
+	 * @brief Starts workerCount_ workers (at most the worker capacity).
+	 */
+	bool Start(uint8_t workerCount_);
+
+	/**
+	 * @brief Runs the queued jobs to the end and joins the workers.
+	 */
+	void Stop();
+	auto IsRunning() const -> bool {return mWorkerCount > 0;}
+
+	/**
+	 * @brief Allocates a registry entry whose handler runs on the pool.
+	 * 		Arm it through the registry as usual.
+	 *
+	 * @return The registry handle, INVALID_HANDLE if the executor or the registry is full.
+	 */
+	TimerRegistry::Handle Add(TimerRegistry::Callback callback_, void* context_);
+
+	/**
+	 * @brief Releases the entry, after its handler finished if queued or running.
+	 */
+	void Remove(TimerRegistry::Handle handle_);
+
+	Stats GetStats() const;
+	auto GetWorkerCount() const -> uint8_t {return mWorkerCount;}
+
+
+private:
+
+	enum JobState : uint8_t {
+		JOB_IDLE,
+		JOB_QUEUED,
+		JOB_RUNNING,
+		//	Expired again while running; runs once more.
+		JOB_RUNNING_AGAIN
+	};
+
+	static void OnExpiry(void* context_, TimerRegistry::Handle handle_);
+
+	void Push(uint16_t job_);
+	//	Takes the oldest job of the own deque, else steals one; INVALID_ID if none.
+	uint16_t Take(uint8_t worker_);
+	void Run(uint16_t job_);
+	void WorkerLoop(uint8_t worker_);
+
+	TimerRegistry& mRegistry;
+	Job* mJobs;
+	Worker* mWorkers;
+	uint16_t* mQueues;
+	uint16_t mCapacity;
+	uint8_t mWorkerCapacity;
+	uint8_t mWorkerCount{0};
+	uint8_t mNextWorker{0};
+
+	//	Bumped on every push; idle workers wait on it.
+	std::atomic<uint32_t> mWorkSequence{0};
+	std::atomic<uint32_t> mSleepers{0};
+	std::atomic<bool> mStopping{false};
+
+	std::atomic<uint64_t> mExecuted{0};
+	std::atomic<uint64_t> mCoalesced{0};
+	std::atomic<uint64_t> mSteals{0};
+	std::atomic<uint64_t> mQueueDelaySumMicros{0};
+	std::atomic<uint32_t> mMaxQueueDelayMicros{0};
+
+};
+
+
+/**
+ * 	Storage for StaticParallelExecutor, see TimerRegistryStorage.
+ */
+template <uint16_t JOBS, uint8_t WORKERS>
+struct ParallelExecutorStorage {
+	ParallelExecutor::Job mJobStorage[JOBS];
+	ParallelExecutor::Worker mWorkerStorage[WORKERS];
+	uint16_t mQueueStorage[WORKERS * JOBS];
+};
+
+/**
+ * 	ParallelExecutor for up to JOBS entries and WORKERS workers.
+ */
+template <uint16_t JOBS, uint8_t WORKERS>
+class StaticParallelExecutor : private ParallelExecutorStorage<JOBS, WORKERS>, public ParallelExecutor {
+
+public:
+
+	explicit StaticParallelExecutor(TimerRegistry& registry_) :
+		ParallelExecutor(registry_, {this->mJobStorage, this->mWorkerStorage, this->mQueueStorage}, JOBS, WORKERS)
+	{
+	}
+
+};
+
+#endif
@@ -0,0 +1,317 @@
+#include "PersistentTimerState.hpp"
+
+#if defined(__linux__)
+
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+	constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+	constexpr uint32_t FNV_PRIME = 16777619u;
+
+	constexpr const char* BOOT_ID_PATH = "/proc/sys/kernel/random/boot_id";
+
+}
+
+PersistentTimerState::PersistentTimerState(TimerRegistry& registry_, Binding* bindings_, uint16_t capacity_) :
+	mRegistry(registry_),
+	mBindings(bindings_),
+	mCapacity(capacity_)
+{
+	for (uint16_t index = 0; index < mCapacity; ++index)
+		mBindings[index] = Binding{TimerRegistry::INVALID_HANDLE, TimerRegistry::NO_DEADLINE, 0};
+}
+
+PersistentTimerState::~PersistentTimerState()
+{
+	Close();
+}
+
+bool PersistentTimerState::Open(const char* path_)
+{
+	if (IsOpen())
+		return false;
+
+	const int fd = open(path_, O_RDWR | O_CREAT, 0600);
+	if (fd < 0)
+		return false;
+
+	const size_t size = FileSize(mCapacity);
+	struct stat status;
+	if (fstat(fd, &status) != 0
+		|| (static_cast<size_t>(status.st_size) != size && ftruncate(fd, static_cast<off_t>(size)) != 0))
+	{
+		close(fd);
+		return false;
+	}
+
+	void* file = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (MAP_FAILED == file)
+		return false;
+
+	mFile = file;
+	mHeader = static_cast<Header*>(file);
+	mRecords = reinterpret_cast<Record*>(static_cast<uint8_t*>(file) + sizeof(Header));
+
+	char bootId[BOOT_ID_SIZE] = {};
+	ReadBootId(bootId);
+	const uint64_t monotonicNow = MonotonicNow();
+	if (mHeader->mMagic != LAYOUT_MAGIC || mHeader->mVersion != LAYOUT_VERSION || mHeader->mCapacity != mCapacity)
+	{
+		//	Foreign or outdated layout: start over. Zeroed records have no valid copy.
+		memset(file, 0, size);
+		mHeader->mVersion = LAYOUT_VERSION;
+		mHeader->mCapacity = mCapacity;
+		mHeader->mSyncedAt = monotonicNow;
+		memcpy(mHeader->mBootId, bootId, BOOT_ID_SIZE);
+		mHeader->mMagic = LAYOUT_MAGIC;
+		return true;
+	}
+
+	//	A rebase interrupted by a crash is completed first, onto the clock it was started for.
+	if (mHeader->mRebaseEpoch != mHeader->mEpoch)
+		CompleteRebase();
+	//	The clock check still catches a reboot where the boot id cannot be read.
+	if (memcmp(mHeader->mBootId, bootId, BOOT_ID_SIZE) != 0 || monotonicNow < mHeader->mSyncedAt)
+		Rebase(bootId, monotonicNow);
+	return true;
+}
+
+void PersistentTimerState::Close()
+{
+	if (!IsOpen())
+		return;
+
+	munmap(mFile, FileSize(mCapacity));
+	mFile = nullptr;
+	mHeader = nullptr;
+	mRecords = nullptr;
+}
+
+bool PersistentTimerState::Track(TimerRegistry::Handle handle_, uint32_t key_)
+{
+	if (!IsOpen() || NO_KEY == key_ || !mRegistry.IsValid(handle_))
+		return false;
+
+	int32_t index = FindRecord(key_);
+	if (index >= 0)
+	{
+		const Record& record = mRecords[index];
+		const Copy& copy = record.mCopies[NewestCopy(record)];
+		Binding& binding = mBindings[index];
+		binding.mHandle = handle_;
+		if (TimerRegistry::NO_DEADLINE == copy.mDeadline)
+		{
+			binding.mDeadline = TimerRegistry::NO_DEADLINE;
+			binding.mPeriod = copy.mPeriod;
+			return true;
+		}
+
+		//	Open() rebased the deadlines after a reboot, so they are on the current clock.
+		const uint64_t monotonicNow = MonotonicNow();
+		const uint64_t remaining = copy.mDeadline > monotonicNow ? copy.mDeadline - monotonicNow : 0;
+
+		mRegistry.ArmAt(handle_, mRegistry.Now() + remaining, copy.mPeriod);
+		binding.mDeadline = mRegistry.DeadlineOf(handle_);
+		binding.mPeriod = copy.mPeriod;
+		return true;
+	}
+
+	for (index = 0; index < mCapacity; ++index)
+	{
+		const Record& record = mRecords[index];
+		const int8_t newest = NewestCopy(record);
+		if (newest >= 0 && record.mCopies[newest].mKey != NO_KEY)
+			continue;
+
+		Binding& binding = mBindings[index];
+		binding.mHandle = handle_;
+		binding.mDeadline = mRegistry.DeadlineOf(handle_);
+		binding.mPeriod = mRegistry.PeriodOf(handle_);
+		const uint64_t monotonicNow = MonotonicNow();
+		const uint64_t registryNow = mRegistry.Now();
+		WriteRecord(static_cast<uint16_t>(index), key_,
+					TimerRegistry::NO_DEADLINE == binding.mDeadline
+						? TimerRegistry::NO_DEADLINE
+						: binding.mDeadline - registryNow + monotonicNow,
+					binding.mPeriod, mHeader->mEpoch);
+		return false;
+	}
+	return false;
+}
+
+void PersistentTimerState::Untrack(uint32_t key_)
+{
+	const int32_t index = FindRecord(key_);
+	if (index < 0)
+		return;
+
+	WriteRecord(static_cast<uint16_t>(index), NO_KEY, TimerRegistry::NO_DEADLINE, 0, mHeader->mEpoch);
+	mBindings[index] = Binding{TimerRegistry::INVALID_HANDLE, TimerRegistry::NO_DEADLINE, 0};
+}
+
+uint16_t PersistentTimerState::Sync()
+{
+	if (!IsOpen())
+		return 0;
+
+	uint16_t written = 0;
+	const uint64_t monotonicNow = MonotonicNow();
+	const uint64_t registryNow = mRegistry.Now();
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		Binding& binding = mBindings[index];
+		if (!mRegistry.IsValid(binding.mHandle))
+			continue;
+
+		const uint64_t deadline = mRegistry.DeadlineOf(binding.mHandle);
+		const uint32_t period = mRegistry.PeriodOf(binding.mHandle);
+		if (deadline == binding.mDeadline && period == binding.mPeriod)
+			continue;
+
+		binding.mDeadline = deadline;
+		binding.mPeriod = period;
+		const Record& record = mRecords[index];
+		WriteRecord(index, record.mCopies[NewestCopy(record)].mKey,
+					TimerRegistry::NO_DEADLINE == deadline ? TimerRegistry::NO_DEADLINE : deadline - registryNow + monotonicNow,
+					period, mHeader->mEpoch);
+		++written;
+	}
+
+	//	A single aligned 64 bit store; either the old or the new value survives.
+	mHeader->mSyncedAt = monotonicNow;
+	return written;
+}
+
+bool PersistentTimerState::Flush()
+{
+	return IsOpen() && msync(mFile, FileSize(mCapacity), MS_SYNC) == 0;
+}
+
+uint64_t PersistentTimerState::MonotonicNow()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+
+size_t PersistentTimerState::FileSize(uint16_t capacity_)
+{
+	return sizeof(Header) + static_cast<size_t>(capacity_) * sizeof(Record);
+}
+
+uint32_t PersistentTimerState::CheckOf(const Copy& copy_)
+{
+	//	FNV-1a over everything but the check itself.
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&copy_);
+	uint32_t check = FNV_OFFSET_BASIS;
+	for (size_t index = 0; index < offsetof(Copy, mCheck); ++index)
+	{
+		check ^= bytes[index];
+		check *= FNV_PRIME;
+	}
+	return check;
+}
+
+void PersistentTimerState::ReadBootId(char (&bootId_)[BOOT_ID_SIZE])
+{
+	const int fd = open(BOOT_ID_PATH, O_RDONLY);
+	if (fd < 0)
+		return;
+
+	if (read(fd, bootId_, BOOT_ID_SIZE) != static_cast<ssize_t>(BOOT_ID_SIZE))
+		memset(bootId_, 0, BOOT_ID_SIZE);
+	close(fd);
+}
+
+int8_t PersistentTimerState::NewestCopy(const Record& record_)
+{
+	const Copy& first = record_.mCopies[0];
+	const Copy& second = record_.mCopies[1];
+	//	A zero sequence is never written, so zeroed copies are invalid.
+	const bool firstValid = first.mSequence != 0 && CheckOf(first) == first.mCheck;
+	const bool secondValid = second.mSequence != 0 && CheckOf(second) == second.mCheck;
+
+	if (firstValid && secondValid)
+		return static_cast<int32_t>(second.mSequence - first.mSequence) > 0 ? 1 : 0;
+	if (firstValid)
+		return 0;
+	return secondValid ? 1 : -1;
+}
+
+int32_t PersistentTimerState::FindRecord(uint32_t key_) const
+{
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		const Record& record = mRecords[index];
+		const int8_t newest = NewestCopy(record);
+		if (newest >= 0 && record.mCopies[newest].mKey == key_)
+			return index;
+	}
+	return -1;
+}
+
+void PersistentTimerState::WriteRecord(uint16_t index_, uint32_t key_, uint64_t deadline_, uint32_t period_, uint32_t epoch_)
+{
+	Record& record = mRecords[index_];
+	const int8_t newest = NewestCopy(record);
+
+	Copy copy{};
+	copy.mDeadline = deadline_;
+	copy.mKey = key_;
+	copy.mPeriod = period_;
+	copy.mEpoch = epoch_;
+	copy.mSequence = newest < 0 ? 1 : record.mCopies[newest].mSequence + 1;
+	if (0 == copy.mSequence)
+		copy.mSequence = 1;
+	copy.mCheck = CheckOf(copy);
+
+	//	Overwrite the older copy; the newer one stays valid until this one is complete.
+	record.mCopies[newest < 0 ? 0 : 1 - newest] = copy;
+}
+
+void PersistentTimerState::Rebase(const char (&bootId_)[BOOT_ID_SIZE], uint64_t monotonicNow_)
+{
+	//	Source and target first. Nothing read by Open() changes before the epoch store below, so a
+	//	crash until then simply starts over.
+	mHeader->mRebaseFrom = mHeader->mSyncedAt;
+	mHeader->mRebaseTo = monotonicNow_;
+	memcpy(mHeader->mRebaseBootId, bootId_, BOOT_ID_SIZE);
+	mHeader->mRebaseEpoch = mHeader->mEpoch + 1;
+	CompleteRebase();
+}
+
+void PersistentTimerState::CompleteRebase()
+{
+	//	Every record at once, so records tracked only after the next Sync() are not misread.
+	const uint32_t epoch = mHeader->mRebaseEpoch;
+	for (uint16_t index = 0; index < mCapacity; ++index)
+	{
+		const Record& record = mRecords[index];
+		const int8_t newest = NewestCopy(record);
+		if (newest < 0)
+			continue;
+
+		//	Moved already by the run that crashed.
+		const Copy& copy = record.mCopies[newest];
+		if (NO_KEY == copy.mKey || TimerRegistry::NO_DEADLINE == copy.mDeadline || copy.mEpoch == epoch)
+			continue;
+
+		const uint64_t remaining = copy.mDeadline > mHeader->mRebaseFrom ? copy.mDeadline - mHeader->mRebaseFrom : 0;
+		WriteRecord(index, copy.mKey, mHeader->mRebaseTo + remaining, copy.mPeriod, epoch);
+	}
+
+	memcpy(mHeader->mBootId, mHeader->mRebaseBootId, BOOT_ID_SIZE);
+	mHeader->mSyncedAt = mHeader->mRebaseTo;
+	//	Last: until here, the next Open() completes the rebase again.
+	mHeader->mEpoch = epoch;
+}
+
+#endif
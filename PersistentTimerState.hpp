@@ -0,0 +1,194 @@
+/**
+ * 	PersistentTimerState class (Linux only).
+ *
+ * 	Keeps the deadlines of selected TimerRegistry entries in a memory-mapped
+ * 	file, so a restarted daemon resumes each timer with its remaining time
+ * 	instead of starting all periods from zero (which lets long maintenance
+ * 	periods run late or never).
+ *
+ * 	Entries are tracked under a stable key (f.e. a name hash, see
+ * 	TimerDirectory::HashName()), as handles may differ after a restart.
+ * 	Track() restores the entry from the file if it is found there. Sync()
+ * 	then writes changed deadlines back in place - a few bytes per changed
+ * 	entry, no serialization pass. Deadlines are kept as CLOCK_MONOTONIC
+ * 	time, so the time the daemon was down is accounted for on restore.
+ *
+ * 	Every record holds two copies, each with a sequence number and a
+ * 	checksum. Sync() always overwrites the older copy, so a crash in the
+ * 	middle of a write leaves the newer one intact.
+ *
+ * There are a few things to keep in mind:
+ * 		- Call Sync() after Dispatch() (and after arming tracked entries).
+ * 			What was not synced before a crash is lost.
+ * 		- CLOCK_MONOTONIC restarts on reboot. The file keeps the kernel's
+ * 			boot id; if it differs (or the clock is behind the last Sync()),
+ * 			Open() restores the remaining times as of that Sync() - the
+ * 			downtime is unknown.
+ * 		- That rebase survives a crash in the middle: its source and target
+ * 			clock are stored in the header before any record is touched, and
+ * 			each record carries the epoch (rebase count) it was written in.
+ * 			The next Open() completes it, skipping records already moved.
+ * 		- The file is reinitialized if its layout (magic, version, capacity)
+ * 			does not match.
+ * 		- Writes go to the page cache; they survive a crash of the process,
+ * 			but only Flush() (msync) makes them survive a power loss.
+ */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class PersistentTimerState {
+
+public:
+
+	static constexpr uint32_t LAYOUT_MAGIC = 0x53505450;	// "PTPS"
+	static constexpr uint16_t LAYOUT_VERSION = 3;
+	//	A UUID in text form, without the trailing newline.
+	static constexpr size_t BOOT_ID_SIZE = 36;
+	//	Keys are user defined, except this one, which marks a free record.
+	static constexpr uint32_t NO_KEY = 0;
+
+	//	Process-local state per record.
+	struct Binding {
+		TimerRegistry::Handle mHandle;
+		uint64_t mDeadline;
+		uint32_t mPeriod;
+	};
+
+	/**
+	 * @brief Creates a closed state. Prefer StaticPersistentTimerState<N>.
+	 */
+	PersistentTimerState(TimerRegistry& registry_, Binding* bindings_, uint16_t capacity_);
+	~PersistentTimerState();
+
+	PersistentTimerState(const PersistentTimerState&) = delete;
+	PersistentTimerState& operator=(const PersistentTimerState&) = delete;
+
+	/**
+	 * @brief Opens (or creates) the state file and maps it.
+	 */
+	bool Open(const char* path_);
+	void Close();
+	auto IsOpen() const -> bool {return nullptr != mFile;}
+
+	/**
+	 * @brief Tracks the entry under key_. If the file holds a record for
+	 * 		key_, the entry is armed with the remaining time and period from
+	 * 		there (an overdue entry fires on the next Dispatch()).
+	 *
+	 * @return True if the entry was restored from the file.
+	 */
+	bool Track(TimerRegistry::Handle handle_, uint32_t key_);
+
+	/**
+	 * @brief Stops tracking key_ and frees its record.
+	 */
+	void Untrack(uint32_t key_);
+
+	/**
+	 * @brief Writes deadlines and periods of tracked entries that changed since
+	 * 		the last Sync().
+	 *
+	 * @return The number of records written.
+	 */
+	uint16_t Sync();
+
+	/**
+	 * @brief Flushes the mapping to the file (msync). Blocks.
+	 */
+	bool Flush();
+
+	/**
+	 * @brief Returns CLOCK_MONOTONIC in milliseconds.
+	 */
+	static uint64_t MonotonicNow();
+
+
+private:
+
+	struct Copy {
+		//	CLOCK_MONOTONIC deadline; TimerRegistry::NO_DEADLINE if not armed.
+		uint64_t mDeadline;
+		uint32_t mKey;
+		uint32_t mPeriod;
+		uint32_t mSequence;
+		//	Header epoch whose clock mDeadline is on.
+		uint32_t mEpoch;
+		uint32_t mCheck;
+	};
+
+	struct Record {
+		Copy mCopies[2];
+	};
+
+	struct Header {
+		uint32_t mMagic;
+		uint16_t mVersion;
+		uint16_t mCapacity;
+		//	Bumped by every rebase; a rebase is under way while mRebaseEpoch differs.
+		uint32_t mEpoch;
+		uint32_t mRebaseEpoch;
+		//	CLOCK_MONOTONIC at the last Sync(), of the boot below.
+		uint64_t mSyncedAt;
+		//	The rebase under way: last Sync() of the old clock, Open() on the new one.
+		uint64_t mRebaseFrom;
+		uint64_t mRebaseTo;
+		char mBootId[BOOT_ID_SIZE];
+		char mRebaseBootId[BOOT_ID_SIZE];
+	};
+
+	static size_t FileSize(uint16_t capacity_);
+	static uint32_t CheckOf(const Copy& copy_);
+	//	Leaves bootId_ zeroed if it cannot be read.
+	static void ReadBootId(char (&bootId_)[BOOT_ID_SIZE]);
+
+	//	Index of the newest valid copy of a record, -1 if none.
+	static int8_t NewestCopy(const Record& record_);
+
+	int32_t FindRecord(uint32_t key_) const;
+	void WriteRecord(uint16_t index_, uint32_t key_, uint64_t deadline_, uint32_t period_, uint32_t epoch_);
+	//	Starts moving all deadlines from the clock of a previous boot to the current one.
+	void Rebase(const char (&bootId_)[BOOT_ID_SIZE], uint64_t monotonicNow_);
+	//	Moves the records not moved yet and completes the rebase stored in the header.
+	void CompleteRebase();
+
+	TimerRegistry& mRegistry;
+	Binding* mBindings;
+	uint16_t mCapacity;
+
+	void* mFile{nullptr};
+	Header* mHeader{nullptr};
+	Record* mRecords{nullptr};
+
+};
+
+
+/**
+ * 	Storage for StaticPersistentTimerState, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct PersistentTimerStateStorage {
+	PersistentTimerState::Binding mBindingStorage[CAPACITY];
+};
+
+/**
+ * 	PersistentTimerState with built-in storage for CAPACITY tracked entries.
+ */
+template <uint16_t CAPACITY>
+class StaticPersistentTimerState : private PersistentTimerStateStorage<CAPACITY>, public PersistentTimerState {
+
+public:
+
+	explicit StaticPersistentTimerState(TimerRegistry& registry_) :
+		PersistentTimerState(registry_, this->mBindingStorage, CAPACITY)
+	{
+	}
+
+};
+
+#endif
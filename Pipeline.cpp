@@ -0,0 +1,132 @@
+#include "Pipeline.hpp"
+
+Pipeline::Pipeline(TimerRegistry& registry_, Stage* stages_, StageId capacity_) :
+	mRegistry(registry_),
+	mStages(stages_),
+	mCapacity(capacity_)
+{
+}
+
+Pipeline::~Pipeline()
+{
+	for (StageId stage = 0; stage < mCount; ++stage)
+		mRegistry.Remove(mStages[stage].mHandle);
+}
+
+Pipeline::StageId Pipeline::AddStage(Process process_, void* context_, uint32_t periodMillis_,
+										FrameRing* input_, uint16_t decimation_, FrameRing* output_)
+{
+	if (mCount >= mCapacity)
+		return INVALID_STAGE;
+	//	A zero period would run the stage once; more frames than the input holds never arrive.
+	const uint16_t decimation = decimation_ > 0 ? decimation_ : 1;
+	if (!process_ || 0 == periodMillis_ || (input_ && decimation > input_->GetFrameCount())
+		|| (output_ && 0 == output_->GetFrameCount()))
+		return INVALID_STAGE;
+
+	Stage& stage = mStages[mCount];
+	stage = Stage{};
+	stage.mHandle = mRegistry.Add(OnTick, &stage);
+	if (TimerRegistry::INVALID_HANDLE == stage.mHandle)
+		return INVALID_STAGE;
+
+	stage.mProcess = process_;
+	stage.mContext = context_;
+	stage.mInput = input_;
+	stage.mOutput = output_;
+	stage.mPeriodMillis = periodMillis_;
+	stage.mDecimation = decimation;
+	return mCount++;
+}
+
+void Pipeline::SetMaxRunsPerTick(StageId stage_, uint8_t runs_)
+{
+	if (stage_ < mCount)
+		mStages[stage_].mMaxRunsPerTick = runs_ > 0 ? runs_ : 1;
+}
+
+void Pipeline::Start()
+{
+	for (StageId stage = 0; stage < mCount; ++stage)
+		mRegistry.ArmAfter(mStages[stage].mHandle, mStages[stage].mPeriodMillis, mStages[stage].mPeriodMillis);
+}
+
+void Pipeline::Stop()
+{
+	for (StageId stage = 0; stage < mCount; ++stage)
+		mRegistry.Cancel(mStages[stage].mHandle);
+}
+
+uint16_t Pipeline::GetInputDepth(StageId stage_) const
+{
+	if (stage_ >= mCount || !mStages[stage_].mInput)
+		return 0;
+	return mStages[stage_].mInput->GetDepth();
+}
+
+uint32_t Pipeline::GetRunsPerSecond(StageId stage_) const
+{
+	if (stage_ >= mCount)
+		return 0;
+	const Stage& stage = mStages[stage_];
+	const uint64_t elapsedMillis = static_cast<uint64_t>(stage.mStats.mTicks) * stage.mPeriodMillis;
+	if (0 == elapsedMillis)
+		return 0;
+	return static_cast<uint32_t>(static_cast<uint64_t>(stage.mStats.mRuns) * 1000 / elapsedMillis);
+}
+
+void Pipeline::ResetStats()
+{
+	for (StageId stage = 0; stage < mCount; ++stage)
+		mStages[stage].mStats = StageStats{};
+}
+
+void Pipeline::OnTick(void* context_, TimerRegistry::Handle)
+{
+	RunStage(*static_cast<Stage*>(context_));
+}
+
+void Pipeline::RunStage(Stage& stage_)
+{
+	StageStats& stats = stage_.mStats;
+	++stats.mTicks;
+	if (stage_.mInput && stage_.mInput->GetDepth() > stats.mMaxInputDepth)
+		stats.mMaxInputDepth = stage_.mInput->GetDepth();
+
+	for (uint8_t run = 0; run < stage_.mMaxRunsPerTick; ++run)
+	{
+		if (stage_.mInput && stage_.mInput->GetDepth() < stage_.mDecimation)
+		{
+			if (0 == run)
+				++stats.mStarvedTicks;
+			return;
+		}
+
+		uint8_t* output = nullptr;
+		if (stage_.mOutput)
+		{
+			output = stage_.mOutput->BeginWrite();
+			if (!output)
+			{
+				++stats.mBlockedTicks;
+				return;
+			}
+		}
+
+		const uint32_t startMicros = micros();
+		const bool produced = stage_.mProcess(stage_.mContext, stage_.mInput, output);
+		stats.mBusyMicros += micros() - startMicros;
+		++stats.mRuns;
+
+		if (stage_.mInput)
+		{
+			stage_.mInput->Release(stage_.mDecimation);
+			stats.mFramesIn += stage_.mDecimation;
+		}
+		if (output && produced)
+		{
+			stage_.mOutput->CommitWrite();
+			++stats.mFramesOut;
+		}
+	}
+}
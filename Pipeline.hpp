@@ -0,0 +1,161 @@
+/**
+ * 	Pipeline class.
+ *
+ * 	A chain of processing stages (f.e. sample ADC -> filter -> extract
+ * 	features -> publish), each running at its own rate from a periodic
+ * 	TimerRegistry entry. Stages pass data through FrameRings by reference:
+ * 	a stage reads its input frames in place and writes its output directly
+ * 	into the next free frame of its output ring.
+ *
+ * 	A stage with a decimation ratio of n consumes n input frames per run
+ * 	and produces (at most) one output frame. Stages without input are
+ * 	sources and run on every tick; stages without output are sinks.
+ *
+ * 	Per stage, the pipeline counts runs, frames in and out, ticks starved
+ * 	(not enough input) and blocked (output ring full), the maximum input
+ * 	queue depth and the time spent processing.
+ *
+ * There are a few things to keep in mind:
+ * 		- Per tick a stage runs at most mMaxRunsPerTick times (default 1), so
+ * 			its rate limits its throughput. Allow more runs to let a stage
+ * 			catch up after the loop was late.
+ * 		- A blocked stage does not consume its input, so back pressure
+ * 			propagates upstream and shows up as blocked ticks there.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <limits>
+
+#include "FrameRing.hpp"
+#include "TimerRegistry.hpp"
+
+class Pipeline {
+
+public:
+
+	using StageId = uint8_t;
+
+	/**
+	 * Processes one run of a stage.
+	 *
+	 * @param input_: The input ring (nullptr for sources); frames 0 .. decimation - 1
+	 * 					are available via Peek() and released after the call.
+	 * @param output_: The frame to fill (nullptr for sinks).
+	 * @return True if output_ was filled and is to be committed.
+	 */
+	using Process = bool (*)(void* context_, const FrameRing* input_, uint8_t* output_);
+
+	//	Returned by AddStage() if there is no free stage slot or an argument is invalid.
+	static constexpr StageId INVALID_STAGE = std::numeric_limits<StageId>::max();
+
+	struct StageStats {
+		uint32_t mTicks{0};
+		uint32_t mRuns{0};
+		uint32_t mFramesIn{0};
+		uint32_t mFramesOut{0};
+		uint32_t mStarvedTicks{0};
+		uint32_t mBlockedTicks{0};
+		uint16_t mMaxInputDepth{0};
+		uint64_t mBusyMicros{0};
+	};
+
+	struct Stage {
+		Process mProcess{nullptr};
+		void* mContext{nullptr};
+		FrameRing* mInput{nullptr};
+		FrameRing* mOutput{nullptr};
+		uint32_t mPeriodMillis{0};
+		uint16_t mDecimation{1};
+		uint8_t mMaxRunsPerTick{1};
+		TimerRegistry::Handle mHandle{TimerRegistry::INVALID_HANDLE};
+		StageStats mStats;
+	};
+
+	/**
+	 * @brief Creates an empty pipeline on the passed stage storage. Prefer StaticPipeline<N>.
+	 */
+	Pipeline(TimerRegistry& registry_, Stage* stages_, StageId capacity_);
+	~Pipeline();
+
+	Pipeline(const Pipeline&) = delete;
+	Pipeline& operator=(const Pipeline&) = delete;
+
+	/**
+	 * @brief Adds a stage.
+	 *
+	 * @param periodMillis_: Interval the stage is run in, not 0.
+	 * @param input_: Ring to read from, nullptr for a source.
+	 * @param decimation_: Input frames consumed per output frame, at most the input's frame count.
+	 * @param output_: Ring to write to, nullptr for a sink.
+	 * @return The id of the stage, INVALID_STAGE if full, out of registry entries,
+	 * 		process_ is nullptr, the period or decimation is invalid or a ring has
+	 * 		no frames.
+	 */
+	StageId AddStage(Process process_, void* context_, uint32_t periodMillis_,
+						FrameRing* input_, uint16_t decimation_, FrameRing* output_);
+
+	/**
+	 * @brief Allows the stage to run up to runs_ times per tick to catch up.
+	 */
+	void SetMaxRunsPerTick(StageId stage_, uint8_t runs_);
+
+	/**
+	 * @brief Starts / stops all stages.
+	 */
+	void Start();
+	void Stop();
+
+	auto GetStageCount() const -> StageId {return mCount;}
+	auto GetStageStats(StageId stage_) const -> const StageStats& {return mStages[stage_].mStats;}
+
+	/**
+	 * @brief Returns the current input queue depth of the stage (0 for sources).
+	 */
+	uint16_t GetInputDepth(StageId stage_) const;
+
+	/**
+	 * @brief Returns the throughput of the stage in runs per second,
+	 * 		based on the ticks seen so far.
+	 */
+	uint32_t GetRunsPerSecond(StageId stage_) const;
+
+	void ResetStats();
+
+
+private:
+
+	static void OnTick(void* context_, TimerRegistry::Handle handle_);
+	static void RunStage(Stage& stage_);
+
+	TimerRegistry& mRegistry;
+	Stage* mStages;
+	StageId mCapacity;
+	StageId mCount{0};
+
+};
+
+
+/**
+ * 	Storage for StaticPipeline, see TimerRegistryStorage.
+ */
+template <Pipeline::StageId CAPACITY>
+struct PipelineStorage {
+	Pipeline::Stage mStageStorage[CAPACITY];
+};
+
+/**
+ * 	Pipeline with built-in storage for CAPACITY stages.
+ */
+template <Pipeline::StageId CAPACITY>
+class StaticPipeline : private PipelineStorage<CAPACITY>, public Pipeline {
+
+public:
+
+	explicit StaticPipeline(TimerRegistry& registry_) :
+		Pipeline(registry_, this->mStageStorage, CAPACITY)
+	{
+	}
+
+};
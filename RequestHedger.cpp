@@ -0,0 +1,209 @@
+#include "RequestHedger.hpp"
+
+#include <string.h>
+
+#include "Timer.hpp"
+
+namespace {
+
+	//	Index of the first value greater than value_ (after all equal ones).
+	uint16_t UpperBound(const uint32_t* sorted_, uint16_t count_, uint32_t value_)
+	{
+		uint16_t low = 0;
+		uint16_t high = count_;
+		while (low < high)
+		{
+			const uint16_t middle = static_cast<uint16_t>((low + high) / 2);
+			if (sorted_[middle] <= value_)
+				low = static_cast<uint16_t>(middle + 1);
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+}
+
+RequestHedger::RequestHedger(TimerRegistry& registry_, Operation* operations_, uint8_t operationCount_,
+								const WindowStorage& single_, const WindowStorage& effective_, const Config& config_) :
+	mRegistry(registry_),
+	mOperations(operations_),
+	mOperationCount(operationCount_),
+	mSingle{single_, 0, 0},
+	mEffective{effective_, 0, 0},
+	mConfig(config_)
+{
+	if (mConfig.mMaxHedges > MAX_ATTEMPTS - 1)
+		mConfig.mMaxHedges = MAX_ATTEMPTS - 1;
+	//	Every operation a control operation would never hedge.
+	if (mConfig.mControlEvery < 2)
+		mConfig.mControlEvery = 2;
+	for (uint8_t index = 0; index < mOperationCount; ++index)
+	{
+		mOperations[index] = Operation{};
+		mOperations[index].mHedgeHandle = mRegistry.Add(OnHedge, this);
+	}
+}
+
+RequestHedger::~RequestHedger()
+{
+	for (uint8_t index = 0; index < mOperationCount; ++index)
+		mRegistry.Remove(mOperations[index].mHedgeHandle);
+}
+
+void RequestHedger::SetCallbacks(HedgeCallback onHedge_, CancelCallback onCancel_, void* context_)
+{
+	mOnHedge = onHedge_;
+	mOnCancel = onCancel_;
+	mContext = context_;
+}
+
+RequestHedger::OperationId RequestHedger::Begin()
+{
+	for (uint8_t index = 0; index < mOperationCount; ++index)
+	{
+		Operation& operation = mOperations[index];
+		if (operation.mActive)
+			continue;
+
+		operation.mActive = true;
+		operation.mStartMillis = mRegistry.Now();
+		operation.mAttempts = 1;
+		++mStats.mOperations;
+
+		//	Not hedging yet: every operation measures single requests.
+		const uint32_t hedgeDelayMillis = mConfig.mMaxHedges > 0 ? GetHedgeDelayMillis() : 0;
+		operation.mControl = 0 == hedgeDelayMillis || 0 == mStats.mOperations % mConfig.mControlEvery;
+		if (operation.mControl)
+			++mStats.mControlOperations;
+		else
+			mRegistry.ArmAt(operation.mHedgeHandle, operation.mStartMillis + hedgeDelayMillis);
+		return index;
+	}
+	return INVALID_OPERATION;
+}
+
+bool RequestHedger::Complete(OperationId operation_, uint8_t attempt_)
+{
+	if (operation_ >= mOperationCount)
+		return false;
+	Operation& operation = mOperations[operation_];
+	if (!operation.mActive || attempt_ >= operation.mAttempts)
+		return false;
+
+	const uint32_t elapsedMillis = NarrowConvertToUint32(mRegistry.Now() - operation.mStartMillis);
+	if (operation.mControl)
+		mSingle.Add(elapsedMillis);
+	else
+		mEffective.Add(elapsedMillis);
+	if (attempt_ > 0)
+		++mStats.mHedgeWins;
+
+	const uint8_t attemptsMask = static_cast<uint8_t>((1u << operation.mAttempts) - 1);
+	const uint8_t outstandingMask = static_cast<uint8_t>(attemptsMask & ~(1u << attempt_));
+	Finish(operation);
+	if (outstandingMask && mOnCancel)
+		mOnCancel(mContext, operation_, attempt_, outstandingMask);
+	return true;
+}
+
+void RequestHedger::Abort(OperationId operation_)
+{
+	if (operation_ >= mOperationCount || !mOperations[operation_].mActive)
+		return;
+
+	++mStats.mAborted;
+	Finish(mOperations[operation_]);
+}
+
+uint32_t RequestHedger::GetHedgeDelayMillis() const
+{
+	if (mSingle.mCount < mConfig.mMinSamples || 0 == mSingle.mCount)
+		return mConfig.mInitialHedgeMillis;
+
+	//	At least 1 ms, as 0 means "no hedging".
+	const uint32_t delayMillis = mSingle.Percentile(mConfig.mPercentile);
+	return delayMillis > 0 ? delayMillis : 1;
+}
+
+uint32_t RequestHedger::GetSingleLatencyMillis(uint8_t percentile_) const
+{
+	return mSingle.Percentile(percentile_);
+}
+
+uint32_t RequestHedger::GetEffectiveLatencyMillis(uint8_t percentile_) const
+{
+	return mEffective.Percentile(percentile_);
+}
+
+uint16_t RequestHedger::GetExtraLoadPercent() const
+{
+	if (0 == mStats.mOperations)
+		return 0;
+	const uint64_t percent = static_cast<uint64_t>(mStats.mHedges) * 100 / mStats.mOperations;
+	return percent > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(percent);
+}
+
+void RequestHedger::OnHedge(void* context_, TimerRegistry::Handle handle_)
+{
+	RequestHedger& hedger = *static_cast<RequestHedger*>(context_);
+	for (uint8_t index = 0; index < hedger.mOperationCount; ++index)
+	{
+		Operation& operation = hedger.mOperations[index];
+		if (operation.mHedgeHandle != handle_ || !operation.mActive)
+			continue;
+
+		const uint64_t nowMillis = hedger.mRegistry.Now();
+		const uint8_t attempt = operation.mAttempts++;
+		++hedger.mStats.mHedges;
+
+		//	Further duplicates follow at the same delay.
+		if (attempt < hedger.mConfig.mMaxHedges)
+			hedger.mRegistry.ArmAt(handle_, nowMillis + hedger.GetHedgeDelayMillis());
+		if (hedger.mOnHedge)
+			hedger.mOnHedge(hedger.mContext, index, attempt);
+		return;
+	}
+}
+
+void RequestHedger::Finish(Operation& operation_)
+{
+	mRegistry.Cancel(operation_.mHedgeHandle);
+	operation_.mActive = false;
+}
+
+void RequestHedger::Window::Add(uint32_t value_)
+{
+	if (0 == mStorage.mCapacity)
+		return;
+
+	uint32_t* sorted = mStorage.mSorted;
+	if (mCount == mStorage.mCapacity)
+	{
+		//	Drop the oldest value: remove one of its occurrences from the sorted copy.
+		const uint32_t oldest = mStorage.mRing[mNext];
+		const uint16_t position = static_cast<uint16_t>(UpperBound(sorted, mCount, oldest) - 1);
+		memmove(sorted + position, sorted + position + 1, (mCount - position - 1) * sizeof(uint32_t));
+		--mCount;
+	}
+
+	const uint16_t position = UpperBound(sorted, mCount, value_);
+	memmove(sorted + position + 1, sorted + position, (mCount - position) * sizeof(uint32_t));
+	sorted[position] = value_;
+	++mCount;
+
+	mStorage.mRing[mNext] = value_;
+	mNext = static_cast<uint16_t>((mNext + 1) % mStorage.mCapacity);
+}
+
+uint32_t RequestHedger::Window::Percentile(uint8_t percentile_) const
+{
+	if (0 == mCount)
+		return 0;
+
+	//	Nearest rank: the smallest value with at least percentile_ % of the values at or below it.
+	uint32_t rank = (static_cast<uint32_t>(mCount) * percentile_ + 99) / 100;
+	if (rank > mCount)
+		rank = mCount;
+	return mStorage.mSorted[rank > 0 ? rank - 1 : 0];
+}
@@ -0,0 +1,211 @@
+/**
+ * 	RequestHedger class.
+ *
+ * 	Cuts the tail latency of queries to redundant responders (sensors,
+ * 	gateways) instead of waiting out the full timeout on a slow one:
+ * 		- the latencies of single requests are kept in a sliding window;
+ * 		- Begin() arms a hedge deadline at the chosen percentile of them;
+ * 		- if no response came in by then, the hedge callback asks for a
+ * 			duplicate request (f.e. to the other responder);
+ * 		- the first Complete() wins, the others are to be cancelled - the
+ * 			cancel callback names the attempts still outstanding.
+ *
+ * 	So only the slowest (100 - percentile) % of the operations cost an
+ * 	extra request. GetExtraLoadPercent() and GetTailImprovementMillis()
+ * 	report what that buys: the extra requests per operation, and how much
+ * 	earlier the percentile of the effective latency (first completion) is
+ * 	than that of single requests.
+ *
+ * 	Once hedging, slow single requests are cancelled and never seen, which
+ * 	would bias the estimate low. So every mControlEvery-th operation is a
+ * 	control operation that is not hedged; only those (and all operations
+ * 	before hedging starts) feed the single request latencies.
+ *
+ * There are a few things to keep in mind:
+ * 		- Without mMinSamples samples there is no estimate yet; then
+ * 			mInitialHedgeMillis is used (0 = no hedging until then).
+ * 		- With hedging active, the single request window fills at one in
+ * 			mControlEvery operations only; size it accordingly.
+ * 		- Attempts are numbered from 0 (the original request).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class RequestHedger {
+
+public:
+
+	using OperationId = uint8_t;
+	static constexpr OperationId INVALID_OPERATION = 0xFF;
+	static constexpr uint8_t MAX_ATTEMPTS = 4;
+
+	struct Config {
+		//	Percentile of the single request latency to hedge at.
+		uint8_t mPercentile{95};
+		uint16_t mMinSamples{20};
+		uint32_t mInitialHedgeMillis{0};
+		//	Duplicates per operation, at most MAX_ATTEMPTS - 1.
+		uint8_t mMaxHedges{1};
+		//	Every n-th operation is not hedged, to keep measuring single requests; at least 2.
+		uint16_t mControlEvery{16};
+	};
+
+	//	Called when a duplicate of the operation should be issued as attempt_.
+	using HedgeCallback = void (*)(void* context_, OperationId operation_, uint8_t attempt_);
+	//	Called after attempt winner_ completed first; outstandingMask_ has a bit per attempt to cancel.
+	using CancelCallback = void (*)(void* context_, OperationId operation_, uint8_t winner_, uint8_t outstandingMask_);
+
+	struct Operation {
+		TimerRegistry::Handle mHedgeHandle;
+		uint64_t mStartMillis;
+		uint8_t mAttempts;
+		bool mActive;
+		bool mControl;
+	};
+
+	//	Storage of a latency window: ring in arrival order and the same values sorted.
+	struct WindowStorage {
+		uint32_t* mRing;
+		uint32_t* mSorted;
+		uint16_t mCapacity;
+	};
+
+	struct Stats {
+		uint32_t mOperations{0};
+		uint32_t mControlOperations{0};
+		uint32_t mHedges{0};
+		uint32_t mHedgeWins{0};
+		uint32_t mAborted{0};
+	};
+
+	/**
+	 * @brief Creates a hedger on the passed storage. Prefer StaticRequestHedger<N, S>.
+	 * 		mControlEvery below 2 is raised to 2 (1 would never hedge), mMaxHedges
+	 * 		is limited to MAX_ATTEMPTS - 1. A window without capacity keeps no
+	 * 		samples, so a hedger without single request storage only ever
+	 * 		hedges at mInitialHedgeMillis.
+	 */
+	RequestHedger(TimerRegistry& registry_, Operation* operations_, uint8_t operationCount_,
+					const WindowStorage& single_, const WindowStorage& effective_, const Config& config_);
+	~RequestHedger();
+
+	RequestHedger(const RequestHedger&) = delete;
+	RequestHedger& operator=(const RequestHedger&) = delete;
+
+	void SetCallbacks(HedgeCallback onHedge_, CancelCallback onCancel_, void* context_);
+
+	/**
+	 * @brief Starts an operation; the caller sends attempt 0 right away.
+	 *
+	 * @return The operation, INVALID_OPERATION if all are in flight.
+	 */
+	OperationId Begin();
+
+	/**
+	 * @brief Reports the response to attempt_.
+	 *
+	 * @return True if it is the first one (use it), false if the operation
+	 * 		is already complete or unknown (drop it).
+	 */
+	bool Complete(OperationId operation_, uint8_t attempt_);
+
+	/**
+	 * @brief Gives up the operation (f.e. on its overall timeout).
+	 */
+	void Abort(OperationId operation_);
+
+	/**
+	 * @brief Returns the delay after which a duplicate is requested,
+	 * 		0 if hedging is not active (yet).
+	 */
+	uint32_t GetHedgeDelayMillis() const;
+
+	/**
+	 * @brief Returns the percentile_ of the single request / effective latency.
+	 */
+	uint32_t GetSingleLatencyMillis(uint8_t percentile_) const;
+	uint32_t GetEffectiveLatencyMillis(uint8_t percentile_) const;
+
+	/**
+	 * @brief Returns how much earlier the percentile_ of the effective latency is.
+	 */
+	auto GetTailImprovementMillis(uint8_t percentile_) const -> int32_t
+	{
+		return static_cast<int32_t>(GetSingleLatencyMillis(percentile_)) - static_cast<int32_t>(GetEffectiveLatencyMillis(percentile_));
+	}
+
+	/**
+	 * @brief Returns the extra requests per operation, in percent.
+	 */
+	uint16_t GetExtraLoadPercent() const;
+
+	auto GetStats() const -> const Stats& {return mStats;}
+
+
+private:
+
+	//	Sliding window kept sorted for O(1) percentiles.
+	struct Window {
+		WindowStorage mStorage;
+		uint16_t mCount;
+		uint16_t mNext;
+
+		void Add(uint32_t value_);
+		uint32_t Percentile(uint8_t percentile_) const;
+	};
+
+	static void OnHedge(void* context_, TimerRegistry::Handle handle_);
+
+	void Finish(Operation& operation_);
+
+	TimerRegistry& mRegistry;
+	Operation* mOperations;
+	uint8_t mOperationCount;
+	Window mSingle;
+	Window mEffective;
+	Config mConfig;
+
+	HedgeCallback mOnHedge{nullptr};
+	CancelCallback mOnCancel{nullptr};
+	void* mContext{nullptr};
+
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticRequestHedger, see TimerRegistryStorage.
+ */
+template <uint8_t OPERATIONS, uint16_t SAMPLES>
+struct RequestHedgerStorage {
+	RequestHedger::Operation mOperationStorage[OPERATIONS];
+	uint32_t mSingleRing[SAMPLES];
+	uint32_t mSingleSorted[SAMPLES];
+	uint32_t mEffectiveRing[SAMPLES];
+	uint32_t mEffectiveSorted[SAMPLES];
+};
+
+/**
+ * 	RequestHedger for OPERATIONS operations in flight, keeping the last
+ * 	SAMPLES latencies.
+ */
+template <uint8_t OPERATIONS, uint16_t SAMPLES = 64>
+class StaticRequestHedger : private RequestHedgerStorage<OPERATIONS, SAMPLES>, public RequestHedger {
+
+	static_assert(SAMPLES > 0, "The latency windows need room for at least one sample");
+
+public:
+
+	StaticRequestHedger(TimerRegistry& registry_, const Config& config_) :
+		RequestHedger(registry_, this->mOperationStorage, OPERATIONS,
+						{this->mSingleRing, this->mSingleSorted, SAMPLES},
+						{this->mEffectiveRing, this->mEffectiveSorted, SAMPLES}, config_)
+	{
+	}
+
+};
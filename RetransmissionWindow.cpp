@@ -0,0 +1,134 @@
+#include "RetransmissionWindow.hpp"
+
+RetransmissionWindow::RetransmissionWindow(TimerRegistry& registry_, RtoEstimator& rto_, Frame* frames_, uint16_t capacity_,
+											RetransmitCallback retransmit_, void* context_) :
+	mRegistry(registry_),
+	mRto(rto_),
+	mFrames(frames_),
+	mCapacity(capacity_),
+	mRetransmit(retransmit_),
+	mContext(context_),
+	mHandle(registry_.Add(OnExpiry, this))
+{
+	Reset();
+}
+
+RetransmissionWindow::~RetransmissionWindow()
+{
+	mRegistry.Remove(mHandle);
+}
+
+bool RetransmissionWindow::Send(Sequence& sequence_)
+{
+	//	The ring place past the last frame is the base frame's.
+	if (!CanSend())
+		return false;
+
+	const uint64_t nowMillis = mRegistry.Now();
+	sequence_ = GetNextSequence();
+	Frame& frame = FrameAt(mInFlight);
+	frame.mSentMillis = static_cast<uint32_t>(nowMillis);
+	frame.mTransmissions = 1;
+	frame.mAcked = false;
+	++mInFlight;
+	++mStats.mSent;
+
+	if (!mRegistry.IsArmed(mHandle))
+		mRegistry.ArmAt(mHandle, nowMillis + mRto.GetTimeoutMillis());
+	return true;
+}
+
+void RetransmissionWindow::AckCumulative(Sequence next_)
+{
+	const uint16_t count = OffsetOf(next_);
+	if (0 == count || count > mInFlight)
+		return;
+
+	//	Only the newest frame is timed: older ones may have waited for a gap to fill.
+	const uint64_t nowMillis = mRegistry.Now();
+	for (uint16_t offset = 0; offset < count; ++offset)
+		Acknowledge(FrameAt(offset), nowMillis, offset + 1 == count);
+	AdvanceBase(nowMillis);
+}
+
+void RetransmissionWindow::AckSelective(Sequence sequence_)
+{
+	const uint16_t offset = OffsetOf(sequence_);
+	if (offset >= mInFlight)
+		return;
+
+	const uint64_t nowMillis = mRegistry.Now();
+	Acknowledge(FrameAt(offset), nowMillis, true);
+	if (0 == offset)
+		AdvanceBase(nowMillis);
+}
+
+void RetransmissionWindow::Reset(Sequence next_)
+{
+	mRegistry.Cancel(mHandle);
+	mBase = next_;
+	mBaseIndex = 0;
+	mInFlight = 0;
+}
+
+void RetransmissionWindow::OnExpiry(void* context_, TimerRegistry::Handle)
+{
+	RetransmissionWindow& window = *static_cast<RetransmissionWindow*>(context_);
+	const uint64_t nowMillis = window.mRegistry.Now();
+	const uint32_t timeoutMillis = window.mRto.GetTimeoutMillis();
+
+	//	The base has timed out; so has every other unacked frame sent as long ago.
+	for (uint16_t offset = 0; offset < window.mInFlight; ++offset)
+	{
+		Frame& frame = window.FrameAt(offset);
+		if (frame.mAcked || (offset > 0 && static_cast<uint32_t>(nowMillis) - frame.mSentMillis < timeoutMillis))
+			continue;
+
+		frame.mSentMillis = static_cast<uint32_t>(nowMillis);
+		if (frame.mTransmissions < 0xFF)
+			++frame.mTransmissions;
+		++window.mStats.mRetransmissions;
+		if (window.mRetransmit)
+			window.mRetransmit(window.mContext, static_cast<Sequence>(window.mBase + offset));
+	}
+
+	if (window.mInFlight > 0)
+	{
+		window.mRto.OnTimeout();
+		window.mRegistry.ArmAt(window.mHandle, nowMillis + window.mRto.GetTimeoutMillis());
+	}
+}
+
+void RetransmissionWindow::Acknowledge(Frame& frame_, uint64_t nowMillis_, bool timed_)
+{
+	if (frame_.mAcked)
+		return;
+
+	frame_.mAcked = true;
+	++mStats.mAcked;
+	//	Karn: the round trip of a retransmitted frame is ambiguous.
+	if (timed_ && 1 == frame_.mTransmissions)
+	{
+		mRto.AddSample(static_cast<uint32_t>(nowMillis_) - frame_.mSentMillis);
+		++mStats.mRttSamples;
+	}
+}
+
+void RetransmissionWindow::AdvanceBase(uint64_t nowMillis_)
+{
+	const Sequence oldBase = mBase;
+	while (mInFlight > 0 && FrameAt(0).mAcked)
+	{
+		++mBase;
+		mBaseIndex = static_cast<uint16_t>((mBaseIndex + 1) % mCapacity);
+		--mInFlight;
+	}
+	if (oldBase == mBase)
+		return;
+
+	//	New oldest frame: restart its deadline, or stop if nothing is left.
+	if (mInFlight > 0)
+		mRegistry.ArmAt(mHandle, nowMillis_ + mRto.GetTimeoutMillis());
+	else
+		mRegistry.Cancel(mHandle);
+}
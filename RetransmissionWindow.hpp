@@ -0,0 +1,153 @@
+/**
+ * 	RetransmissionWindow class.
+ *
+ * 	Retransmission timing for a sliding window protocol with a single
+ * 	registry entry per window instead of one Timer per frame in flight:
+ * 		- Send() assigns the next sequence number and keeps the send time
+ * 			in a ring indexed by the distance to the window base.
+ * 		- One deadline runs for the oldest unacked frame (the base). It is
+ * 			armed when the first frame goes out and restarted whenever an
+ * 			ack moves the base (as RFC 6298 does for TCP).
+ * 		- On expiry, the base frame and every other unacked frame sent at
+ * 			least a timeout ago are retransmitted via callback, the timeout
+ * 			backs off and the deadline is armed again. This is the only pass
+ * 			over the window, and expiries are rare.
+ * 		- AckCumulative() acknowledges everything before a sequence number,
+ * 			AckSelective() a single frame. The base only moves over acked
+ * 			frames, each of which was sent once, so acks cost O(1) amortized.
+ *
+ * 	The timeout comes from an RtoEstimator, fed with the round trip times
+ * 	of frames acked after their first transmission (Karn's algorithm). Of
+ * 	a cumulative ack, only the newest frame is timed.
+ *
+ * There are a few things to keep in mind:
+ * 		- Sequence numbers are 16 bit and wrap; the window must be far
+ * 			smaller than 32768 frames.
+ * 		- Selectively acked frames are never retransmitted.
+ * 		- Acks outside the window are ignored.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "RtoEstimator.hpp"
+#include "TimerRegistry.hpp"
+
+class RetransmissionWindow {
+
+public:
+
+	using Sequence = uint16_t;
+	using RetransmitCallback = void (*)(void* context_, Sequence sequence_);
+
+	struct Frame {
+		//	Low 32 bits of the (last) send time.
+		uint32_t mSentMillis;
+		uint8_t mTransmissions;
+		bool mAcked;
+	};
+
+	struct Stats {
+		uint32_t mSent{0};
+		uint32_t mRetransmissions{0};
+		uint32_t mAcked{0};
+		uint32_t mRttSamples{0};
+	};
+
+	/**
+	 * @brief Creates an empty window on the passed storage.
+	 * 		Prefer StaticRetransmissionWindow<N>.
+	 *
+	 * @param retransmit_: Called to resend a frame on expiry.
+	 */
+	RetransmissionWindow(TimerRegistry& registry_, RtoEstimator& rto_, Frame* frames_, uint16_t capacity_,
+							RetransmitCallback retransmit_, void* context_);
+	~RetransmissionWindow();
+
+	RetransmissionWindow(const RetransmissionWindow&) = delete;
+	RetransmissionWindow& operator=(const RetransmissionWindow&) = delete;
+
+	auto CanSend() const -> bool {return mInFlight < mCapacity;}
+
+	/**
+	 * @brief Registers the transmission of the next frame.
+	 *
+	 * @param sequence_: Set to its sequence number. Every 16 bit value is a
+	 * 					valid one, so there is no invalid sequence to return.
+	 * @return False (and nothing registered) if the window is full, see CanSend().
+	 */
+	bool Send(Sequence& sequence_);
+
+	/**
+	 * @brief Acknowledges all frames before next_ (the peer expects next_).
+	 */
+	void AckCumulative(Sequence next_);
+
+	/**
+	 * @brief Acknowledges the single frame sequence_.
+	 */
+	void AckSelective(Sequence sequence_);
+
+	/**
+	 * @brief Drops all frames in flight and disarms the deadline.
+	 */
+	void Reset(Sequence next_ = 0);
+
+	auto GetBase() const -> Sequence {return mBase;}
+	auto GetNextSequence() const -> Sequence {return static_cast<Sequence>(mBase + mInFlight);}
+	auto GetInFlight() const -> uint16_t {return mInFlight;}
+	auto GetStats() const -> const Stats& {return mStats;}
+
+
+private:
+
+	static void OnExpiry(void* context_, TimerRegistry::Handle handle_);
+
+	auto FrameAt(uint16_t offset_) -> Frame& {return mFrames[(mBaseIndex + offset_) % mCapacity];}
+	//	Distance of sequence_ from the base; >= mInFlight if outside the window.
+	auto OffsetOf(Sequence sequence_) const -> uint16_t {return static_cast<uint16_t>(sequence_ - mBase);}
+
+	void Acknowledge(Frame& frame_, uint64_t nowMillis_, bool timed_);
+	void AdvanceBase(uint64_t nowMillis_);
+
+	TimerRegistry& mRegistry;
+	RtoEstimator& mRto;
+	Frame* mFrames;
+	uint16_t mCapacity;
+	RetransmitCallback mRetransmit;
+	void* mContext;
+	TimerRegistry::Handle mHandle;
+
+	Sequence mBase{0};
+	uint16_t mBaseIndex{0};
+	uint16_t mInFlight{0};
+
+	Stats mStats;
+
+};
+
+
+/**
+ * 	Storage for StaticRetransmissionWindow, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct RetransmissionWindowStorage {
+	RetransmissionWindow::Frame mFrameStorage[CAPACITY];
+};
+
+/**
+ * 	RetransmissionWindow for up to CAPACITY frames in flight.
+ */
+template <uint16_t CAPACITY>
+class StaticRetransmissionWindow : private RetransmissionWindowStorage<CAPACITY>, public RetransmissionWindow {
+
+public:
+
+	StaticRetransmissionWindow(TimerRegistry& registry_, RtoEstimator& rto_,
+								RetransmitCallback retransmit_, void* context_) :
+		RetransmissionWindow(registry_, rto_, this->mFrameStorage, CAPACITY, retransmit_, context_)
+	{
+	}
+
+};
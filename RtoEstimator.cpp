@@ -0,0 +1,62 @@
+#include "RtoEstimator.hpp"
+
+RtoEstimator::RtoEstimator(const Config& config_) :
+	mConfig(config_)
+{
+	Reset();
+}
+
+void RtoEstimator::AddSample(uint32_t rttMillis_)
+{
+	//	Keep the scaled state within 32 bits.
+	if (rttMillis_ > (UINT32_MAX >> SRTT_SHIFT))
+		rttMillis_ = UINT32_MAX >> SRTT_SHIFT;
+
+	if (0 == mSampleCount)
+	{
+		//	First sample: SRTT = R, RTTVAR = R / 2.
+		mScaledSrtt = rttMillis_ << SRTT_SHIFT;
+		mScaledRttvar = (rttMillis_ << RTTVAR_SHIFT) / 2;
+	}
+	else
+	{
+		//	In scaled units: RTTVAR += |err| - RTTVAR / 4, SRTT += err with err = R - SRTT.
+		const int64_t error = static_cast<int64_t>(rttMillis_) - (mScaledSrtt >> SRTT_SHIFT);
+		const uint32_t deviation = static_cast<uint32_t>(error < 0 ? -error : error);
+		mScaledRttvar = mScaledRttvar - (mScaledRttvar >> RTTVAR_SHIFT) + deviation;
+		mScaledSrtt = static_cast<uint32_t>(static_cast<int64_t>(mScaledSrtt) + error);
+	}
+	++mSampleCount;
+	mBackoffCount = 0;
+
+	//	The scaled RTTVAR is exactly the 4 RTTVAR term.
+	const uint32_t variance = mScaledRttvar;
+	mTimeoutMillis = Clamp(static_cast<uint64_t>(mScaledSrtt >> SRTT_SHIFT)
+							+ (variance > mConfig.mGranularityMillis ? variance : mConfig.mGranularityMillis));
+}
+
+void RtoEstimator::OnTimeout()
+{
+	++mTimeoutCount;
+	if (mBackoffCount < 0xFF)
+		++mBackoffCount;
+	mTimeoutMillis = Clamp(static_cast<uint64_t>(mTimeoutMillis) * 2);
+}
+
+void RtoEstimator::Reset()
+{
+	mScaledSrtt = 0;
+	mScaledRttvar = 0;
+	mSampleCount = 0;
+	mBackoffCount = 0;
+	mTimeoutMillis = Clamp(mConfig.mInitialMillis);
+}
+
+uint32_t RtoEstimator::Clamp(uint64_t timeoutMillis_) const
+{
+	if (timeoutMillis_ < mConfig.mMinMillis)
+		return mConfig.mMinMillis;
+	if (timeoutMillis_ > mConfig.mMaxMillis)
+		return mConfig.mMaxMillis;
+	return static_cast<uint32_t>(timeoutMillis_);
+}
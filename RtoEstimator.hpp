@@ -0,0 +1,91 @@
+/**
+ * 	RtoEstimator class.
+ *
+ * 	Adaptive retransmission timeout for request / response protocols (serial,
+ * 	radio), instead of a fixed Timer interval that is either too short for
+ * 	slow links or too long for fast ones. Measured round trip times are
+ * 	smoothed the Jacobson / Karels way (as in TCP, RFC 6298):
+ * 		RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - sample|
+ * 		SRTT   = 7/8 SRTT + 1/8 sample
+ * 		RTO    = SRTT + max(granularity, 4 RTTVAR)
+ * 	in integer arithmetic with scaled state (SRTT x8, RTTVAR x4), so each
+ * 	update is a few shifts and adds.
+ *
+ * 	On a timeout the RTO is doubled (exponential backoff) until the next
+ * 	valid sample. Arm the response timeout with GetTimeoutMillis(), f.e.
+ * 	registry.ArmAfter(handle, rto.GetTimeoutMillis()).
+ *
+ * There are a few things to keep in mind:
+ * 		- Do not feed samples of retransmitted requests (Karn's algorithm):
+ * 			it is unknown which transmission the response belongs to.
+ * 		- The timeout is clamped to [mMinMillis, mMaxMillis], also while
+ * 			backing off.
+ * 		- Until the first sample, mInitialMillis is used.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+class RtoEstimator {
+
+public:
+
+	struct Config {
+		uint32_t mInitialMillis{1000};
+		uint32_t mMinMillis{200};
+		uint32_t mMaxMillis{60000};
+		//	Clock granularity; lower bound of the variance term.
+		uint32_t mGranularityMillis{1};
+	};
+
+	explicit RtoEstimator(const Config& config_);
+
+	/**
+	 * @brief Adds a measured round trip time and ends any backoff.
+	 */
+	void AddSample(uint32_t rttMillis_);
+
+	/**
+	 * @brief Backs off after a timeout: doubles the timeout.
+	 */
+	void OnTimeout();
+
+	/**
+	 * @brief Forgets all samples; back to mInitialMillis.
+	 */
+	void Reset();
+
+	/**
+	 * @brief Returns the timeout to arm for the next (re)transmission.
+	 */
+	auto GetTimeoutMillis() const -> uint32_t {return mTimeoutMillis;}
+
+	auto GetSmoothedRttMillis() const -> uint32_t {return mScaledSrtt >> SRTT_SHIFT;}
+	auto GetRttVarianceMillis() const -> uint32_t {return mScaledRttvar >> RTTVAR_SHIFT;}
+	auto GetSampleCount() const -> uint32_t {return mSampleCount;}
+	auto GetTimeoutCount() const -> uint32_t {return mTimeoutCount;}
+
+	/**
+	 * @brief Returns the number of consecutive timeouts (backoff steps) since the last sample.
+	 */
+	auto GetBackoffCount() const -> uint8_t {return mBackoffCount;}
+
+
+private:
+
+	//	SRTT is kept x8, RTTVAR x4: the gains 1/8 and 1/4 become shifts.
+	static constexpr uint8_t SRTT_SHIFT = 3;
+	static constexpr uint8_t RTTVAR_SHIFT = 2;
+
+	uint32_t Clamp(uint64_t timeoutMillis_) const;
+
+	Config mConfig;
+	uint32_t mScaledSrtt{0};
+	uint32_t mScaledRttvar{0};
+	uint32_t mTimeoutMillis;
+	uint32_t mSampleCount{0};
+	uint32_t mTimeoutCount{0};
+	uint8_t mBackoffCount{0};
+
+};
@@ -0,0 +1,108 @@
+/**
+ * 	Seqlock class template.
+ *
+ * 	Publishes a value from one writer (f.e. the loop on core 1) to any
+ * 	number of readers (f.e. a telemetry task on core 0) without locks:
+ * 		- the writer is wait-free: it bumps a sequence counter to an odd
+ * 			value, stores the value and bumps the counter to even again.
+ * 		- readers copy the value and retry if the counter was odd or changed
+ * 			meanwhile, so they never see a torn value (f.e. half of a
+ * 			uint64_t counter).
+ *
+ * 	The value is stored as 32 bit atomic words, so copying it is free of
+ * 	data races in the C++ memory model. T must be trivially copyable.
+ *
+ * There are a few things to keep in mind:
+ * 		- Only one writer at a time. Several writers need an outer lock.
+ * 		- Readers may have to retry while the writer is active; Read() gives
+ * 			up after maxRetries_ and returns false. Keep T small.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class Seqlock {
+
+	static_assert(std::is_trivially_copyable<T>::value, "Seqlock requires a trivially copyable type");
+
+public:
+
+	Seqlock()
+	{
+		Store(T{});
+	}
+
+	explicit Seqlock(const T& value_)
+	{
+		Store(value_);
+	}
+
+	Seqlock(const Seqlock&) = delete;
+	Seqlock& operator=(const Seqlock&) = delete;
+
+	/**
+	 * @brief Publishes value_. Wait-free, single writer only.
+	 */
+	void Write(const T& value_)
+	{
+		const uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+		mSequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		Store(value_);
+		mSequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	/**
+	 * @brief Copies the last published value to value_.
+	 *
+	 * @return False if no consistent copy could be taken within maxRetries_ attempts.
+	 */
+	bool Read(T& value_, uint32_t maxRetries_ = 1000) const
+	{
+		uint32_t words[WORD_COUNT];
+		for (uint32_t attempt = 0; attempt <= maxRetries_; ++attempt)
+		{
+			const uint32_t before = mSequence.load(std::memory_order_acquire);
+			if (before & 1u)
+				continue;
+
+			for (size_t word = 0; word < WORD_COUNT; ++word)
+				words[word] = mWords[word].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (mSequence.load(std::memory_order_relaxed) == before)
+			{
+				memcpy(&value_, words, sizeof(T));
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * @brief Returns the number of Write() calls so far.
+	 */
+	auto GetVersion() const -> uint32_t {return mSequence.load(std::memory_order_acquire) / 2;}
+
+
+private:
+
+	static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+	void Store(const T& value_)
+	{
+		uint32_t words[WORD_COUNT] = {};
+		memcpy(words, &value_, sizeof(T));
+		for (size_t word = 0; word < WORD_COUNT; ++word)
+			mWords[word].store(words[word], std::memory_order_relaxed);
+	}
+
+	std::atomic<uint32_t> mSequence{0};
+	std::atomic<uint32_t> mWords[WORD_COUNT];
+
+};
@@ -0,0 +1,406 @@
+#include "SharedTimerRegistry.hpp"
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "TimerRegistry.hpp"
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared slots require lock-free 64 bit atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "Shared slots require lock-free 32 bit atomics");
+
+namespace {
+
+	constexpr uint32_t INDEX_MASK = 0xFFFF;
+	constexpr uint32_t GENERATION_SHIFT = 16;
+
+	//	Layout of the slot words, see SharedTimerRegistry::Slot.
+	constexpr uint64_t TAG_MASK = 0xFFFF;
+	constexpr uint32_t DEADLINE_SHIFT = 16;
+	constexpr uint64_t DEADLINE_NEVER = (1ull << 48) - 1;
+	constexpr uint32_t PERIOD_SHIFT = 32;
+
+	uint64_t PackDeadline(uint64_t deadlineMillis_, uint32_t tag_)
+	{
+		const uint64_t deadline = deadlineMillis_ < DEADLINE_NEVER ? deadlineMillis_ : DEADLINE_NEVER;
+		return deadline << DEADLINE_SHIFT | (tag_ & TAG_MASK);
+	}
+
+	uint64_t DeadlineOfWord(uint64_t word_)
+	{
+		const uint64_t deadline = word_ >> DEADLINE_SHIFT;
+		return DEADLINE_NEVER == deadline ? SharedTimerRegistry::NO_DEADLINE : deadline;
+	}
+
+	uint64_t PackPeriod(uint32_t periodMillis_, uint32_t generation_, uint32_t tag_)
+	{
+		return static_cast<uint64_t>(periodMillis_) << PERIOD_SHIFT | static_cast<uint64_t>(generation_ & INDEX_MASK) << GENERATION_SHIFT
+				| (tag_ & TAG_MASK);
+	}
+
+	auto PeriodOfWord(uint64_t word_) -> uint32_t {return static_cast<uint32_t>(word_ >> PERIOD_SHIFT);}
+	auto GenerationOfWord(uint64_t word_) -> uint32_t {return static_cast<uint32_t>(word_ >> GENERATION_SHIFT) & INDEX_MASK;}
+	auto TagOf(uint64_t word_) -> uint16_t {return static_cast<uint16_t>(word_ & TAG_MASK);}
+	//	Tags wrap; a writer more than 32767 writes behind loses.
+	auto IsNewer(uint16_t tag_, uint16_t than_) -> bool {return static_cast<int16_t>(tag_ - than_) > 0;}
+
+	//	Process-shared futex calls (no FUTEX_PRIVATE_FLAG).
+	void FutexWait(std::atomic<uint32_t>& word_, uint32_t expected_, uint32_t timeoutMillis_)
+	{
+		timespec timeout;
+		timeout.tv_sec = timeoutMillis_ / 1000;
+		timeout.tv_nsec = static_cast<long>(timeoutMillis_ % 1000) * 1000000L;
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAIT, expected_, &timeout, nullptr, 0);
+	}
+
+	void FutexWakeAll(std::atomic<uint32_t>& word_)
+	{
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word_), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+	}
+
+}
+
+SharedTimerRegistry::~SharedTimerRegistry()
+{
+	Close();
+}
+
+bool SharedTimerRegistry::Open(const char* name_, uint16_t capacity_)
+{
+	if (IsOpen() || 0 == capacity_ || capacity_ == INDEX_MASK)
+		return false;
+
+	const size_t size = SegmentSize(capacity_);
+	int fd = shm_open(name_, O_RDWR | O_CREAT, 0600);
+	if (fd < 0)
+		return false;
+
+	//	Serializes creation; released by the kernel if the holder dies.
+	struct stat status;
+	if (flock(fd, LOCK_EX) != 0 || fstat(fd, &status) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	//	Empty: just created, or the creator died before sizing it.
+	bool initialize = 0 == status.st_size;
+	if ((initialize && ftruncate(fd, static_cast<off_t>(size)) != 0)
+		|| (!initialize && static_cast<size_t>(status.st_size) != size))
+	{
+		close(fd);
+		return false;
+	}
+
+	void* segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (MAP_FAILED == segment)
+	{
+		close(fd);
+		return false;
+	}
+
+	//	No magic: the creator died before finishing; nobody can have opened it since.
+	Header* header = static_cast<Header*>(segment);
+	if (initialize || header->mMagic.load(std::memory_order_acquire) != LAYOUT_MAGIC)
+		InitializeSegment(segment, capacity_);
+	else if (header->mVersion != LAYOUT_VERSION || header->mCapacity != capacity_)
+	{
+		munmap(segment, size);
+		close(fd);
+		return false;
+	}
+	//	Explicitly: the mapping keeps the file description, and so the lock, alive.
+	flock(fd, LOCK_UN);
+	close(fd);
+
+	mSegment = segment;
+	mSize = size;
+	mHeader = header;
+	mSlots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(segment) + sizeof(Header));
+	return true;
+}
+
+void SharedTimerRegistry::Close()
+{
+	if (!IsOpen())
+		return;
+
+	int32_t self = static_cast<int32_t>(getpid());
+	mHeader->mDispatcherPid.compare_exchange_strong(self, 0);
+	munmap(mSegment, mSize);
+	mSegment = nullptr;
+	mHeader = nullptr;
+	mSlots = nullptr;
+	mSize = 0;
+}
+
+bool SharedTimerRegistry::Unlink(const char* name_)
+{
+	return shm_unlink(name_) == 0;
+}
+
+uint16_t SharedTimerRegistry::Capacity() const
+{
+	return mHeader ? static_cast<uint16_t>(mHeader->mCapacity) : 0;
+}
+
+SharedTimerRegistry::Handle SharedTimerRegistry::Add()
+{
+	const uint16_t capacity = Capacity();
+	for (uint16_t index = 0; index < capacity; ++index)
+	{
+		Slot& slot = mSlots[index];
+		uint32_t expected = 0;
+		if (!slot.mAllocated.compare_exchange_strong(expected, 1, std::memory_order_acq_rel))
+			continue;
+
+		//	Only Remove() changes the generation, and the slot is ours now.
+		const uint32_t generation = GenerationOfWord(slot.mPeriodWord.load(std::memory_order_acquire));
+		Publish(slot, generation, generation, 0, NO_DEADLINE);
+		return generation << GENERATION_SHIFT | index;
+	}
+	return INVALID_HANDLE;
+}
+
+void SharedTimerRegistry::Remove(Handle handle_)
+{
+	Slot* slot = SlotOf(handle_);
+	if (!slot)
+		return;
+
+	//	The new generation makes every write with the old handle fail from here on.
+	const uint32_t generation = handle_ >> GENERATION_SHIFT;
+	if (Publish(*slot, generation, generation + 1, 0, NO_DEADLINE))
+		slot->mAllocated.store(0, std::memory_order_release);
+}
+
+void SharedTimerRegistry::ArmAt(Handle handle_, uint64_t deadlineMillis_, uint32_t periodMillis_)
+{
+	Slot* slot = SlotOf(handle_);
+	if (!slot)
+		return;
+
+	const uint32_t generation = handle_ >> GENERATION_SHIFT;
+	if (Publish(*slot, generation, generation, periodMillis_, deadlineMillis_))
+		NotifyDispatcher();
+}
+
+void SharedTimerRegistry::ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_)
+{
+	ArmAt(handle_, Now() + delayMillis_, periodMillis_);
+}
+
+void SharedTimerRegistry::Cancel(Handle handle_)
+{
+	Slot* slot = SlotOf(handle_);
+	if (!slot)
+		return;
+
+	//	No need to wake the dispatcher: it just finds nothing due.
+	const uint32_t generation = handle_ >> GENERATION_SHIFT;
+	Publish(*slot, generation, generation, PeriodOfWord(slot->mPeriodWord.load(std::memory_order_acquire)), NO_DEADLINE);
+}
+
+uint64_t SharedTimerRegistry::DeadlineOf(Handle handle_) const
+{
+	const Slot* slot = SlotOf(handle_);
+	return slot ? DeadlineOfWord(slot->mDeadlineWord.load(std::memory_order_acquire)) : NO_DEADLINE;
+}
+
+uint32_t SharedTimerRegistry::FireSequenceOf(Handle handle_) const
+{
+	const Slot* slot = SlotOf(handle_);
+	return slot ? slot->mFireSequence.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedTimerRegistry::WaitForExpiry(Handle handle_, uint32_t& seenSequence_, uint32_t timeoutMillis_)
+{
+	Slot* slot = SlotOf(handle_);
+	if (!slot)
+		return false;
+
+	uint32_t sequence = slot->mFireSequence.load(std::memory_order_acquire);
+	if (sequence == seenSequence_)
+	{
+		//	Returns at once if the sequence changed meanwhile.
+		FutexWait(slot->mFireSequence, seenSequence_, timeoutMillis_);
+		sequence = slot->mFireSequence.load(std::memory_order_acquire);
+		if (sequence == seenSequence_)
+			return false;
+	}
+	seenSequence_ = sequence;
+	return true;
+}
+
+bool SharedTimerRegistry::TryBecomeDispatcher()
+{
+	if (!IsOpen())
+		return false;
+
+	const int32_t self = static_cast<int32_t>(getpid());
+	int32_t holder = mHeader->mDispatcherPid.load(std::memory_order_acquire);
+	if (holder == self)
+		return true;
+
+	//	Take over from a dispatcher that died without Close().
+	if (holder != 0 && kill(holder, 0) != 0 && ESRCH == errno)
+		return mHeader->mDispatcherPid.compare_exchange_strong(holder, self, std::memory_order_acq_rel);
+
+	holder = 0;
+	return mHeader->mDispatcherPid.compare_exchange_strong(holder, self, std::memory_order_acq_rel);
+}
+
+uint16_t SharedTimerRegistry::Dispatch(uint64_t nowMillis_)
+{
+	mNextDeadline = NO_DEADLINE;
+	if (!IsOpen() || mHeader->mDispatcherPid.load(std::memory_order_acquire) != static_cast<int32_t>(getpid()))
+		return 0;
+
+	uint16_t fired = 0;
+	uint64_t nextDeadline = NO_DEADLINE;
+	const uint16_t capacity = Capacity();
+	for (uint16_t index = 0; index < capacity; ++index)
+	{
+		//	Deadline first: its writer published the period before it.
+		Slot& slot = mSlots[index];
+		uint64_t deadlineWord = slot.mDeadlineWord.load(std::memory_order_acquire);
+		const uint64_t periodWord = slot.mPeriodWord.load(std::memory_order_acquire);
+		//	Tags apart: a write is under way and wakes the dispatcher when done.
+		if (TagOf(deadlineWord) != TagOf(periodWord))
+			continue;
+
+		const uint64_t deadline = DeadlineOfWord(deadlineWord);
+		if (deadline > nowMillis_)
+		{
+			if (deadline < nextDeadline)
+				nextDeadline = deadline;
+			continue;
+		}
+
+		//	Keeps the tag, so the pair stays matched. Fails if the entry was
+		//	re-armed or cancelled meanwhile; that change wins.
+		const uint32_t period = PeriodOfWord(periodWord);
+		const uint64_t next = period > 0
+								? TimerRegistry::NextPeriodicDeadline(deadline, period, nowMillis_)
+								: NO_DEADLINE;
+		if (!slot.mDeadlineWord.compare_exchange_strong(deadlineWord, PackDeadline(next, TagOf(deadlineWord)),
+														std::memory_order_acq_rel))
+			continue;
+
+		if (next < nextDeadline)
+			nextDeadline = next;
+		slot.mFireSequence.fetch_add(1, std::memory_order_release);
+		FutexWakeAll(slot.mFireSequence);
+		++fired;
+	}
+	mNextDeadline = nextDeadline;
+	return fired;
+}
+
+uint16_t SharedTimerRegistry::DispatchAndWait(uint32_t maxWaitMillis_)
+{
+	if (!IsOpen())
+		return 0;
+
+	//	Read before dispatching: a change after this makes the wait return at once.
+	const uint32_t change = mHeader->mChangeSequence.load(std::memory_order_acquire);
+	const uint64_t nowMillis = Now();
+	const uint16_t fired = Dispatch(nowMillis);
+
+	uint32_t waitMillis = maxWaitMillis_;
+	if (mNextDeadline != NO_DEADLINE && mNextDeadline - nowMillis < waitMillis)
+		waitMillis = static_cast<uint32_t>(mNextDeadline - nowMillis);
+	if (waitMillis > 0)
+		FutexWait(mHeader->mChangeSequence, change, waitMillis);
+	return fired;
+}
+
+uint64_t SharedTimerRegistry::Now()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000 + static_cast<uint64_t>(now.tv_nsec) / 1000000;
+}
+
+size_t SharedTimerRegistry::SegmentSize(uint16_t capacity_)
+{
+	return sizeof(Header) + static_cast<size_t>(capacity_) * sizeof(Slot);
+}
+
+SharedTimerRegistry::Slot* SharedTimerRegistry::SlotOf(Handle handle_) const
+{
+	const uint32_t index = handle_ & INDEX_MASK;
+	if (!IsOpen() || index >= Capacity())
+		return nullptr;
+	Slot& slot = mSlots[index];
+	if (!slot.mAllocated.load(std::memory_order_acquire)
+		|| GenerationOfWord(slot.mPeriodWord.load(std::memory_order_acquire)) != handle_ >> GENERATION_SHIFT)
+		return nullptr;
+	return &slot;
+}
+
+bool SharedTimerRegistry::Publish(Slot& slot_, uint32_t generation_, uint32_t newGeneration_,
+									uint32_t periodMillis_, uint64_t deadlineMillis_)
+{
+	//	Period word first, by CAS with the newest tag; the generation is checked in the same CAS.
+	//	A newer tag in the word means another write got there first: retry with a fresh one,
+	//	so the period words are ordered by tag.
+	uint16_t tag;
+	uint64_t periodWord = slot_.mPeriodWord.load(std::memory_order_acquire);
+	for (;;)
+	{
+		if (GenerationOfWord(periodWord) != (generation_ & INDEX_MASK))
+			return false;
+		tag = static_cast<uint16_t>(slot_.mTag.fetch_add(1, std::memory_order_relaxed) + 1);
+		if (!IsNewer(tag, TagOf(periodWord)))
+			periodWord = slot_.mPeriodWord.load(std::memory_order_acquire);
+		else if (slot_.mPeriodWord.compare_exchange_weak(periodWord, PackPeriod(periodMillis_, newGeneration_, tag),
+															std::memory_order_acq_rel))
+			break;
+	}
+
+	//	Then the deadline, unless a newer write already replaced it; the last period writer wins both.
+	uint64_t deadlineWord = slot_.mDeadlineWord.load(std::memory_order_acquire);
+	while (IsNewer(tag, TagOf(deadlineWord))
+			&& !slot_.mDeadlineWord.compare_exchange_weak(deadlineWord, PackDeadline(deadlineMillis_, tag),
+															std::memory_order_acq_rel))
+		;
+	return true;
+}
+
+void SharedTimerRegistry::InitializeSegment(void* segment_, uint16_t capacity_)
+{
+	Header* header = static_cast<Header*>(segment_);
+	Slot* slots = reinterpret_cast<Slot*>(static_cast<uint8_t*>(segment_) + sizeof(Header));
+	for (uint16_t index = 0; index < capacity_; ++index)
+	{
+		Slot& slot = slots[index];
+		slot.mDeadlineWord.store(PackDeadline(NO_DEADLINE, 0), std::memory_order_relaxed);
+		slot.mPeriodWord.store(PackPeriod(0, 0, 0), std::memory_order_relaxed);
+		slot.mTag.store(0, std::memory_order_relaxed);
+		slot.mFireSequence.store(0, std::memory_order_relaxed);
+		slot.mAllocated.store(0, std::memory_order_relaxed);
+	}
+	header->mVersion = LAYOUT_VERSION;
+	header->mCapacity = capacity_;
+	header->mChangeSequence.store(0, std::memory_order_relaxed);
+	header->mDispatcherPid.store(0, std::memory_order_relaxed);
+	header->mMagic.store(LAYOUT_MAGIC, std::memory_order_release);
+}
+
+void SharedTimerRegistry::NotifyDispatcher()
+{
+	mHeader->mChangeSequence.fetch_add(1, std::memory_order_release);
+	FutexWakeAll(mHeader->mChangeSequence);
+}
+
+#endif
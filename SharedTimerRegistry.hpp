@@ -0,0 +1,205 @@
+/**
+ * 	SharedTimerRegistry class (Linux only).
+ *
+ * 	A timer registry living in a POSIX shared memory segment, so several
+ * 	processes on the gateway can share one set of deadlines instead of
+ * 	each running its own polling loop:
+ * 		- any process opens the segment by name, allocates entries and arms
+ * 			or cancels them lock-free. Deadline and period of an entry are
+ * 			two words tagged with the same write tag; writers publish them
+ * 			by CAS, the newest tag wins, and the dispatcher only uses a
+ * 			pair whose tags match. No process ever waits for another.
+ * 		- one process acts as dispatcher: DispatchAndWait() fires all due
+ * 			entries and then sleeps on a futex until the next deadline or
+ * 			until any process changes a deadline.
+ * 		- subscribers wait for their entry with WaitForExpiry(), a futex
+ * 			wait on the entry's fire sequence, which the dispatcher bumps on
+ * 			every expiry.
+ *
+ * 	Times are absolute milliseconds of CLOCK_MONOTONIC (see Now()), which is
+ * 	the same in all processes of one host.
+ *
+ * There are a few things to keep in mind:
+ * 		- Only one process may dispatch at a time. TryBecomeDispatcher()
+ * 			claims the role; it is released by Close() or taken over if the
+ * 			previous dispatcher died.
+ * 		- Periodic entries run at a fixed rate and skip missed periods, like
+ * 			TimerRegistry. If an entry is re-armed while the dispatcher
+ * 			reschedules it, the re-arm wins.
+ * 		- Subscribers are woken, not called back: an expiry that happens
+ * 			while nobody waits is seen as a changed sequence on the next
+ * 			WaitForExpiry(). Several expiries in between count as one.
+ * 		- The futex words are process-shared, so wakeups work across
+ * 			processes without passing file descriptors around (which eventfd
+ * 			would need).
+ * 		- All processes have to open the segment with the same capacity.
+ * 			Open() initializes the segment under an flock(), so a segment
+ * 			left empty or half-initialized by a crashed creator is
+ * 			initialized again by the next Open().
+ * 		- Handles carry a generation: a handle kept after Remove() does not
+ * 			act on the entry once another process re-added it.
+ * 		- A process killed between the two words of a write leaves their
+ * 			tags apart: the entry is not dispatched until it is armed or
+ * 			cancelled again. Nobody blocks on it.
+ * 		- Deadlines are kept in 48 bits (about 8900 years of uptime); later
+ * 			ones mean "never".
+ */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include <Arduino.h>
+#include <atomic>
+#include <limits>
+
+class SharedTimerRegistry {
+
+public:
+
+	//	Generation (upper 16 bits) and entry index (lower 16 bits).
+	using Handle = uint32_t;
+
+	static constexpr Handle INVALID_HANDLE = 0xFFFFFFFF;
+	static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+
+	//	Layout of the segment; bumped on every incompatible change.
+	static constexpr uint32_t LAYOUT_MAGIC = 0x52545354;	// "TSTR"
+	static constexpr uint32_t LAYOUT_VERSION = 3;
+
+	SharedTimerRegistry() = default;
+	~SharedTimerRegistry();
+
+	SharedTimerRegistry(const SharedTimerRegistry&) = delete;
+	SharedTimerRegistry& operator=(const SharedTimerRegistry&) = delete;
+
+	/**
+	 * @brief Opens (and creates, if it does not exist yet) the segment.
+	 *
+	 * @param name_: Shared memory name, f.e. "/gateway-timers".
+	 * @param capacity_: Number of entries; has to match an existing segment.
+	 * @return False if the segment could not be opened or does not match.
+	 */
+	bool Open(const char* name_, uint16_t capacity_);
+
+	/**
+	 * @brief Unmaps the segment. Releases the dispatcher role if held.
+	 */
+	void Close();
+
+	/**
+	 * @brief Removes the segment name; processes still attached keep it.
+	 */
+	static bool Unlink(const char* name_);
+
+	auto IsOpen() const -> bool {return nullptr != mSegment;}
+	uint16_t Capacity() const;
+
+
+	/**
+	 * @brief Allocates an (unarmed) entry. Lock-free.
+	 *
+	 * @return The handle, INVALID_HANDLE if the segment is full.
+	 */
+	Handle Add();
+
+	/**
+	 * @brief Cancels and releases the entry.
+	 */
+	void Remove(Handle handle_);
+
+	/**
+	 * @brief Arms the entry for an absolute deadline (see Now()) and wakes
+	 * 		the dispatcher. Zero period means one-shot.
+	 */
+	void ArmAt(Handle handle_, uint64_t deadlineMillis_, uint32_t periodMillis_ = 0);
+	void ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_ = 0);
+
+	void Cancel(Handle handle_);
+
+	auto IsArmed(Handle handle_) const -> bool {return DeadlineOf(handle_) != NO_DEADLINE;}
+	uint64_t DeadlineOf(Handle handle_) const;
+
+	/**
+	 * @brief Returns the fire sequence of the entry: bumped on every expiry.
+	 */
+	uint32_t FireSequenceOf(Handle handle_) const;
+
+	/**
+	 * @brief Waits until the entry expired after the sequence seen last.
+	 *
+	 * @param seenSequence_: Sequence seen last (start with FireSequenceOf());
+	 * 						updated to the current one if the entry expired.
+	 * @return True if the entry expired, false on timeout.
+	 */
+	bool WaitForExpiry(Handle handle_, uint32_t& seenSequence_, uint32_t timeoutMillis_);
+
+
+	/**
+	 * @brief Claims the dispatcher role. True if it is held by this process now.
+	 */
+	bool TryBecomeDispatcher();
+
+	/**
+	 * @brief Fires all due entries against a single clock reading.
+	 * 		Dispatcher only.
+	 *
+	 * @return The number of expiries; 0 if this process is not the dispatcher.
+	 */
+	uint16_t Dispatch(uint64_t nowMillis_);
+
+	/**
+	 * @brief Dispatches, then sleeps until the next deadline, a change of
+	 * 		any deadline, or maxWaitMillis_ - whichever is first.
+	 * 		Dispatcher only; call it in a loop.
+	 *
+	 * @return The number of expiries.
+	 */
+	uint16_t DispatchAndWait(uint32_t maxWaitMillis_);
+
+	/**
+	 * @brief Returns CLOCK_MONOTONIC in milliseconds.
+	 */
+	static uint64_t Now();
+
+
+private:
+
+	struct Slot {
+		//	Deadline (upper 48 bits) and write tag (lower 16 bits).
+		std::atomic<uint64_t> mDeadlineWord;
+		//	Period (upper 32 bits), generation and write tag (16 bits each).
+		std::atomic<uint64_t> mPeriodWord;
+		//	Source of the write tags.
+		std::atomic<uint32_t> mTag;
+		std::atomic<uint32_t> mFireSequence;
+		std::atomic<uint32_t> mAllocated;
+	};
+
+	//	Aligned, so the slots following it are.
+	struct alignas(alignof(Slot)) Header {
+		std::atomic<uint32_t> mMagic;
+		uint32_t mVersion;
+		uint32_t mCapacity;
+		//	Bumped (and futex-woken) whenever a deadline changes.
+		std::atomic<uint32_t> mChangeSequence;
+		std::atomic<int32_t> mDispatcherPid;
+	};
+
+	static size_t SegmentSize(uint16_t capacity_);
+
+	Slot* SlotOf(Handle handle_) const;
+	//	Writes deadline and period as one unit; false if the generation is not generation_ (any more).
+	static bool Publish(Slot& slot_, uint32_t generation_, uint32_t newGeneration_, uint32_t periodMillis_, uint64_t deadlineMillis_);
+	static void InitializeSegment(void* segment_, uint16_t capacity_);
+	void NotifyDispatcher();
+
+	void* mSegment{nullptr};
+	size_t mSize{0};
+	Header* mHeader{nullptr};
+	Slot* mSlots{nullptr};
+	uint64_t mNextDeadline{NO_DEADLINE};
+
+};
+
+#endif
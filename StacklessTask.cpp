@@ -0,0 +1,44 @@
+#include "StacklessTask.hpp"
+
+StacklessTask::StacklessTask(TimerRegistry& registry_, Body body_, void* context_) :
+	mRegistry(registry_),
+	mBody(body_),
+	mContext(context_),
+	mHandle(registry_.Add(OnResume, this))
+{
+}
+
+StacklessTask::~StacklessTask()
+{
+	mRegistry.Remove(mHandle);
+}
+
+void StacklessTask::Start()
+{
+	mResumePoint = 0;
+	mRegistry.ArmAfter(mHandle, 0);
+}
+
+void StacklessTask::Stop()
+{
+	mRegistry.Cancel(mHandle);
+	mResumePoint = 0;
+}
+
+void StacklessTask::SleepFor(uint32_t millis_)
+{
+	//	Not at Now(): the running Dispatch() would resume the task again at once.
+	mRegistry.ArmAfter(mHandle, millis_ > 0 ? millis_ : 1);
+}
+
+void StacklessTask::SleepUntil(uint64_t atMillis_)
+{
+	mRegistry.ArmAt(mHandle, atMillis_);
+}
+
+void StacklessTask::OnResume(void* context_, TimerRegistry::Handle)
+{
+	StacklessTask& task = *static_cast<StacklessTask*>(context_);
+	if (DONE == task.mBody(task, task.mContext))
+		task.mRegistry.Cancel(task.mHandle);
+}
@@ -0,0 +1,129 @@
+/**
+ * 	StacklessTask class.
+ *
+ * 	Protothread-style tasks for toolchains without C++20 coroutines: a
+ * 	task body is a plain function that reads sequentially, but may wait
+ * 	in between. Waiting returns from the function after noting where to
+ * 	continue; the next call jumps right back there (a switch on the line
+ * 	number). No stack is kept, so local variables do not survive a wait -
+ * 	keep such state in the context object.
+ *
+ * 	Waits are backed by a TimerRegistry: a waiting task is only resumed
+ * 	by Dispatch() once its deadline is reached, it is never polled.
+ *
+ * 		StacklessTask::Status Blink(StacklessTask& task_, void* context_)
+ * 		{
+ * 			TASK_BEGIN(task_);
+ * 			for (;;)
+ * 			{
+ * 				digitalWrite(LED_BUILTIN, HIGH);
+ * 				TASK_WAIT_MS(task_, 100);
+ * 				digitalWrite(LED_BUILTIN, LOW);
+ * 				TASK_WAIT_MS(task_, 900);
+ * 			}
+ * 			TASK_END(task_);
+ * 		}
+ *
+ * 		StacklessTask sBlinkTask(sRegistry, Blink, nullptr);
+ *
+ * There are a few things to keep in mind:
+ * 		- The TASK_ macros must not be used inside a switch statement of
+ * 			the body itself, and at most once per source line.
+ * 		- TASK_YIELD() (and any wait of 0 ms) resumes 1 ms later, i.e. on a
+ * 			later Dispatch(): re-arming at Now() would make the running
+ * 			Dispatch() resume the task again right away.
+ * 		- Per task RAM on ESP32 is about 54 bytes: the task object (16 bytes:
+ * 			registry reference, body and context pointers, handle, resume
+ * 			point) plus its registry entry (20), heap node (16) and heap
+ * 			position (2).
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class StacklessTask {
+
+public:
+
+	enum Status : uint8_t {
+		WAITING,
+		DONE
+	};
+
+	using Body = Status (*)(StacklessTask& task_, void* context_);
+
+	/**
+	 * @brief Creates a stopped task.
+	 *
+	 * @param context_: Passed to the body on every resumption.
+	 */
+	StacklessTask(TimerRegistry& registry_, Body body_, void* context_);
+	~StacklessTask();
+
+	StacklessTask(const StacklessTask&) = delete;
+	StacklessTask& operator=(const StacklessTask&) = delete;
+
+	/**
+	 * @brief (Re-)starts the body from the beginning on the next Dispatch().
+	 */
+	void Start();
+
+	/**
+	 * @brief Stops the task wherever it waits. Start() begins from the beginning.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Returns true while the task has not finished (or was stopped).
+	 */
+	auto IsRunning() const -> bool {return mRegistry.IsArmed(mHandle);}
+
+
+	//	Used by the TASK_ macros only.
+	auto GetResumePoint() const -> uint16_t {return mResumePoint;}
+	auto SetResumePoint(uint16_t resumePoint_) -> void {mResumePoint = resumePoint_;}
+	//	Zero is taken as 1 ms, see TASK_YIELD().
+	void SleepFor(uint32_t millis_);
+	void SleepUntil(uint64_t atMillis_);
+
+
+private:
+
+	static void OnResume(void* context_, TimerRegistry::Handle handle_);
+
+	TimerRegistry& mRegistry;
+	Body mBody;
+	void* mContext;
+	TimerRegistry::Handle mHandle;
+	uint16_t mResumePoint{0};
+
+};
+
+
+//	Starts the body of a task. Must be the first statement.
+#define TASK_BEGIN(task_) \
+	switch ((task_).GetResumePoint()) { case 0:
+
+//	Lets all other due entries of the registry run first, then continues 1 ms later (on a later Dispatch()).
+#define TASK_YIELD(task_) \
+	do { (task_).SleepFor(0); (task_).SetResumePoint(__LINE__); return StacklessTask::WAITING; case __LINE__:; } while (0)
+
+//	Continues after millis_ milliseconds.
+#define TASK_WAIT_MS(task_, millis_) \
+	do { (task_).SleepFor(millis_); (task_).SetResumePoint(__LINE__); return StacklessTask::WAITING; case __LINE__:; } while (0)
+
+//	Continues once the absolute point in time atMillis_ (millis() time line) is reached.
+#define TASK_WAIT_UNTIL(task_, atMillis_) \
+	do { (task_).SleepUntil(atMillis_); (task_).SetResumePoint(__LINE__); return StacklessTask::WAITING; case __LINE__:; } while (0)
+
+//	Continues once condition_ is true, checking it every pollMillis_ milliseconds.
+#define TASK_WAIT_CONDITION(task_, condition_, pollMillis_) \
+	do { (task_).SetResumePoint(__LINE__); [[fallthrough]]; case __LINE__: \
+		if (!(condition_)) { (task_).SleepFor(pollMillis_); return StacklessTask::WAITING; } } while (0)
+
+//	Ends the body of a task. Must be the last statement.
+#define TASK_END(task_) \
+	} (task_).SetResumePoint(0); return StacklessTask::DONE
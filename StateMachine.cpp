@@ -0,0 +1,190 @@
+#include "StateMachine.hpp"
+
+#include "Timer.hpp"
+
+StateMachine::StateMachine(TimerRegistry& registry_, const State* states_, StateId stateCount_, void* context_) :
+	mRegistry(registry_),
+	mStates(states_),
+	mStateCount(stateCount_),
+	mContext(context_),
+	mTimeoutHandle(registry_.Add(OnTimeout, this))
+{
+}
+
+StateMachine::~StateMachine()
+{
+	mRegistry.Remove(mTimeoutHandle);
+}
+
+void StateMachine::Start(StateId initial_)
+{
+	Stop();
+	TransitionTo(initial_);
+}
+
+void StateMachine::Stop()
+{
+	ExitTo(0);
+	mRegistry.Cancel(mTimeoutHandle);
+}
+
+void StateMachine::HandleEvent(const Event& event_)
+{
+	for (uint8_t depth = mDepth; depth > 0; --depth)
+	{
+		const Handler handler = mStates[mChain[depth - 1]].mHandler;
+		if (!handler)
+			continue;
+
+		const StateId result = handler(mContext, event_);
+		if (HANDLED == result)
+			return;
+		if (result != NO_STATE)
+		{
+			TransitionTo(result);
+			return;
+		}
+	}
+}
+
+bool StateMachine::IsIn(StateId state_) const
+{
+	for (uint8_t depth = 0; depth < mDepth; ++depth)
+	{
+		if (mChain[depth] == state_)
+			return true;
+	}
+	return false;
+}
+
+uint32_t StateMachine::TimeInStateMillis() const
+{
+	if (0 == mDepth)
+		return 0;
+	return NarrowConvertToUint32(mRegistry.Now() - mEntryMillis[mDepth - 1]);
+}
+
+void StateMachine::OnTimeout(void* context_, TimerRegistry::Handle)
+{
+	StateMachine& machine = *static_cast<StateMachine*>(context_);
+	const uint64_t nowMillis = machine.mRegistry.Now();
+
+	//	Deliver the earliest expired timeout; further ones follow on re-arming.
+	uint8_t expiredDepth = MAX_DEPTH;
+	uint64_t earliest = TimerRegistry::NO_DEADLINE;
+	for (uint8_t depth = 0; depth < machine.mDepth; ++depth)
+	{
+		const uint32_t timeout = machine.mStates[machine.mChain[depth]].mTimeoutMillis;
+		if (0 == timeout || (machine.mTimedOut & (1u << depth)))
+			continue;
+		const uint64_t deadline = machine.mEntryMillis[depth] + timeout;
+		if (deadline <= nowMillis && deadline <= earliest)
+		{
+			earliest = deadline;
+			expiredDepth = depth;
+		}
+	}
+
+	if (expiredDepth < MAX_DEPTH)
+	{
+		machine.mTimedOut |= static_cast<uint8_t>(1u << expiredDepth);
+		machine.HandleEvent(Event{TIMEOUT_SIGNAL, machine.mChain[expiredDepth]});
+	}
+	machine.ArmTimeout();
+}
+
+void StateMachine::TransitionTo(StateId target_)
+{
+	if (target_ >= mStateCount)
+		return;
+
+	//	Path from the outermost ancestor down to the target.
+	StateId path[MAX_DEPTH];
+	const uint8_t length = DepthOf(target_);
+	if (0 == length)
+		return;
+	StateId state = target_;
+	for (uint8_t index = length; index > 0; --index)
+	{
+		path[index - 1] = state;
+		state = mStates[state].mParent;
+	}
+
+	uint8_t common = 0;
+	while (common < mDepth && common < length && mChain[common] == path[common])
+		++common;
+	if (common == length)
+		--common;	// target is active: exit and re-enter it
+
+	ExitTo(common);
+	EnterChain(path + common, static_cast<uint8_t>(length - common));
+
+	//	Drill down into initial sub states.
+	StateId initial = mStates[mChain[mDepth - 1]].mInitial;
+	while (initial < mStateCount && mDepth < MAX_DEPTH)
+	{
+		EnterChain(&initial, 1);
+		initial = mStates[initial].mInitial;
+	}
+
+	ArmTimeout();
+}
+
+void StateMachine::EnterChain(const StateId* path_, uint8_t count_)
+{
+	const uint64_t nowMillis = mRegistry.Now();
+	for (uint8_t index = 0; index < count_; ++index)
+	{
+		mChain[mDepth] = path_[index];
+		mEntryMillis[mDepth] = nowMillis;
+		mTimedOut &= static_cast<uint8_t>(~(1u << mDepth));
+		++mDepth;
+
+		const Action onEntry = mStates[path_[index]].mOnEntry;
+		if (onEntry)
+			onEntry(mContext);
+	}
+}
+
+void StateMachine::ExitTo(uint8_t depth_)
+{
+	while (mDepth > depth_)
+	{
+		--mDepth;
+		const Action onExit = mStates[mChain[mDepth]].mOnExit;
+		if (onExit)
+			onExit(mContext);
+	}
+}
+
+void StateMachine::ArmTimeout()
+{
+	uint64_t earliest = TimerRegistry::NO_DEADLINE;
+	for (uint8_t depth = 0; depth < mDepth; ++depth)
+	{
+		const uint32_t timeout = mStates[mChain[depth]].mTimeoutMillis;
+		if (0 == timeout || (mTimedOut & (1u << depth)))
+			continue;
+		const uint64_t deadline = mEntryMillis[depth] + timeout;
+		if (deadline < earliest)
+			earliest = deadline;
+	}
+
+	if (TimerRegistry::NO_DEADLINE == earliest)
+		mRegistry.Cancel(mTimeoutHandle);
+	else
+		mRegistry.ArmAt(mTimeoutHandle, earliest);
+}
+
+uint8_t StateMachine::DepthOf(StateId state_) const
+{
+	//	Zero for invalid states or hierarchies deeper than MAX_DEPTH.
+	uint8_t depth = 0;
+	while (state_ < mStateCount)
+	{
+		if (++depth > MAX_DEPTH)
+			return 0;
+		state_ = mStates[state_].mParent;
+	}
+	return depth;
+}
@@ -0,0 +1,143 @@
+/**
+ * 	StateMachine class.
+ *
+ * 	A table-driven hierarchical state machine whose states may declare a
+ * 	timeout. Instead of a Timer member per state (and remembering to reset
+ * 	it on entry and deactivate it on exit), the machine keeps one single
+ * 	TimerRegistry entry, armed for the earliest timeout of the active
+ * 	states. Machines in states without a timeout cost no polling at all.
+ *
+ * 	The states are described by a constant table, indexed by StateId:
+ *
+ * 		const StateMachine::State sStates[] = {
+ * 			//	parent,		initial,	timeout,	entry,		exit,		handler
+ * 			{NO_STATE,		IDLE,		0,			nullptr,	nullptr,	RootHandler},
+ * 			{ROOT,			NO_STATE,	0,			nullptr,	nullptr,	IdleHandler},
+ * 			{ROOT,			NO_STATE,	5000,		StartPump,	StopPump,	PumpingHandler},
+ * 		};
+ *
+ * 	A handler returns the target state of a transition, HANDLED if the
+ * 	event was consumed without a transition, or NO_STATE to pass the event
+ * 	on to the parent state.
+ *
+ * There are a few things to keep in mind:
+ * 		- A state's timeout starts on entry of that state and is delivered
+ * 			once as TIMEOUT_SIGNAL event (mParam = the timed out state) to
+ * 			the innermost active state, bubbling up like any other event.
+ * 		- A transition exits up to the common ancestor and enters down to
+ * 			the target; a transition to an active state (or to itself) exits
+ * 			and re-enters it, restarting its timeout. Entering a composite
+ * 			state continues with its initial sub state.
+ * 		- Entry and exit actions must not trigger transitions.
+ * 		- Hierarchies are limited to MAX_DEPTH levels.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class StateMachine {
+
+public:
+
+	using StateId = uint8_t;
+
+	//	Parent / initial state "none"; handler result "not handled, ask the parent".
+	static constexpr StateId NO_STATE = 0xFF;
+	//	Handler result "handled, no transition".
+	static constexpr StateId HANDLED = 0xFE;
+
+	//	Signal of the event delivered when a state's timeout expires.
+	static constexpr uint16_t TIMEOUT_SIGNAL = 0;
+
+	static constexpr uint8_t MAX_DEPTH = 8;
+
+	struct Event {
+		uint16_t mSignal;
+		uint32_t mParam;
+	};
+
+	using Action = void (*)(void* context_);
+	using Handler = StateId (*)(void* context_, const Event& event_);
+
+	struct State {
+		StateId mParent;
+		//	Sub state entered after this one, NO_STATE for leaf states.
+		StateId mInitial;
+		//	Timeout after entry, 0 = none.
+		uint32_t mTimeoutMillis;
+		Action mOnEntry;
+		Action mOnExit;
+		Handler mHandler;
+	};
+
+	/**
+	 * @brief Creates a machine on the passed state table. Not started yet.
+	 *
+	 * @param context_: Passed to all actions and handlers.
+	 */
+	StateMachine(TimerRegistry& registry_, const State* states_, StateId stateCount_, void* context_);
+	~StateMachine();
+
+	StateMachine(const StateMachine&) = delete;
+	StateMachine& operator=(const StateMachine&) = delete;
+
+	/**
+	 * @brief Enters initial_ (and its ancestors and initial sub states).
+	 * 		If already started, exits all active states first.
+	 */
+	void Start(StateId initial_);
+
+	/**
+	 * @brief Exits all active states and disarms the timeout.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Delivers the event to the innermost active state and performs
+	 * 		the resulting transition.
+	 */
+	void HandleEvent(const Event& event_);
+
+	/**
+	 * @brief Returns the innermost active state, NO_STATE if not started.
+	 */
+	auto GetState() const -> StateId {return mDepth > 0 ? mChain[mDepth - 1] : NO_STATE;}
+
+	/**
+	 * @brief Returns true if state_ is active (the innermost state or an ancestor of it).
+	 */
+	bool IsIn(StateId state_) const;
+
+	/**
+	 * @brief Returns the time the innermost state has been active.
+	 */
+	uint32_t TimeInStateMillis() const;
+
+
+private:
+
+	static void OnTimeout(void* context_, TimerRegistry::Handle handle_);
+
+	void TransitionTo(StateId target_);
+	void EnterChain(const StateId* path_, uint8_t count_);
+	void ExitTo(uint8_t depth_);
+	void ArmTimeout();
+	uint8_t DepthOf(StateId state_) const;
+
+	TimerRegistry& mRegistry;
+	const State* mStates;
+	StateId mStateCount;
+	void* mContext;
+	TimerRegistry::Handle mTimeoutHandle;
+
+	//	Active states, outermost first.
+	StateId mChain[MAX_DEPTH];
+	uint64_t mEntryMillis[MAX_DEPTH];
+	uint8_t mDepth{0};
+	//	Bit per depth: timeout of that level already delivered.
+	uint8_t mTimedOut{0};
+
+};
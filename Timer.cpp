@@ -16,8 +16,19 @@ bool Timer::IntervalReached()
 	if (!mActivated)
 		return false;
 
-	if (mOverrideIntervalReached || (mMillisStartPeriod + mMillisInterval) < millis())
+	const uint64_t nowMillis = millis();
+	const uint64_t intervalEnd = mMillisStartPeriod + mMillisInterval;
+	if (mOverrideIntervalReached || intervalEnd < nowMillis)
 	{
+#if TIMER_STATISTICS
+		if (intervalEnd < nowMillis)
+		{
+			const uint32_t overrunMillis = NarrowConvertToUint32(nowMillis - intervalEnd);
+			if (overrunMillis > mMaxOverrunMillis)
+				mMaxOverrunMillis = overrunMillis;
+		}
+		++mReachedCount;
+#endif
 		ResetInterval();
 		return true;
 	}
@@ -27,7 +38,13 @@ bool Timer::IntervalReached()
 
 uint32_t Timer::TimeLeftInMillis() const
 {
-	return NarrowConvertToUint32(mMillisStartPeriod + static_cast<int64_t>(mMillisInterval) - millis());
+	return TimeLeftInMillis(millis());
+}
+
+uint32_t Timer::TimeLeftInMillis(uint64_t nowMillis_) const
+{
+	//	Unsigned as ever: an overdue timer wraps and reads UINT32_MAX, which existing sketches rely on.
+	return NarrowConvertToUint32(mMillisStartPeriod + mMillisInterval - nowMillis_);
 }
  
 uint32_t Timer::TimePassedInMillis() const
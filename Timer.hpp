@@ -59,6 +59,15 @@
 
 #include <Arduino.h>
 
+//	Per-timer statistics (GetReachedCount(), GetMaxOverrunMillis()) cost 8 bytes
+//	in every Timer, so they are opt-in. Set as a build flag (f.e. -DTIMER_STATISTICS=1),
+//	so all translation units see the same Timer layout. They are single aligned
+//	32 bit words (never torn on another core), so not published via a Seqlock,
+//	which would cost more memory per Timer than the counters themselves.
+#ifndef TIMER_STATISTICS
+#define TIMER_STATISTICS 0
+#endif
+
 using std::numeric_limits;
 
 template <typename T>
@@ -182,14 +191,42 @@ public:
 
 
 	/**
-	 * @brief Returns the time left until the next interval is reached.
+	 * @brief Returns the time left until the next interval is reached
+	 * 		(UINT32_MAX once it is overdue).
 	 */
 	uint32_t TimeLeftInMillis() const;
 
+	/**
+	 * @brief Same as TimeLeftInMillis(), but against a given clock reading
+	 * 		(f.e. to evaluate many timers against the same point in time).
+	 */
+	uint32_t TimeLeftInMillis(uint64_t nowMillis_) const;
+
 	/**
 	 * @brief Returns the time passed since the last interval was reached (and called for).
 	 */
 	uint32_t TimePassedInMillis() const;
+
+	/**
+	 * @brief Returns true if OverrideIntervalReached() is pending.
+	 */
+	auto IsOverridden() const -> bool {return mOverrideIntervalReached;}
+
+#if TIMER_STATISTICS
+	/**
+	 * @brief Returns how often IntervalReached() returned true.
+	 */
+	auto GetReachedCount() const -> uint32_t {return mReachedCount;}
+
+	/**
+	 * @brief Returns the largest time by which an interval was exceeded 
+	 * 		when IntervalReached() noticed it (overrides not counted).
+	 */
+	auto GetMaxOverrunMillis() const -> uint32_t {return mMaxOverrunMillis;}
+#else
+	auto GetReachedCount() const -> uint32_t {return 0;}
+	auto GetMaxOverrunMillis() const -> uint32_t {return 0;}
+#endif
 	
 
 private:
@@ -204,4 +241,9 @@ private:
 
 	bool mActivated{true};
 
+#if TIMER_STATISTICS
+	uint32_t mReachedCount{0};
+	uint32_t mMaxOverrunMillis{0};
+#endif
+
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "TimerDirectory.hpp"
+
+namespace {
+
+	constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+	constexpr uint32_t FNV_PRIME = 16777619u;
+
+	//	Appends value_ as unsigned LEB128; false if it does not fit.
+	bool PutVarint(uint8_t* buffer_, size_t size_, size_t& used_, uint64_t value_)
+	{
+		do
+		{
+			if (used_ >= size_)
+				return false;
+			const uint8_t low = static_cast<uint8_t>(value_ & 0x7F);
+			value_ >>= 7;
+			buffer_[used_++] = value_ ? static_cast<uint8_t>(low | 0x80) : low;
+		} while (value_);
+		return true;
+	}
+
+	bool PutByte(uint8_t* buffer_, size_t size_, size_t& used_, uint8_t value_)
+	{
+		if (used_ >= size_)
+			return false;
+		buffer_[used_++] = value_;
+		return true;
+	}
+
+}
+
+TimerDirectory::TimerDirectory(Record* records_, uint16_t capacity_) :
+	mRecords(records_),
+	mCapacity(capacity_)
+{
+}
+
+bool TimerDirectory::Register(const Timer& timer_, const __FlashStringHelper* name_)
+{
+	if (mCount >= mCapacity || Find(timer_) >= 0)
+		return false;
+
+	mRecords[mCount++] = Record{&timer_, name_, HashName(name_)};
+	return true;
+}
+
+bool TimerDirectory::Register(const Timer& timer_, uint32_t nameHash_)
+{
+	if (mCount >= mCapacity || Find(timer_) >= 0)
+		return false;
+
+	mRecords[mCount++] = Record{&timer_, nullptr, nameHash_};
+	return true;
+}
+
+void TimerDirectory::Unregister(const Timer& timer_)
+{
+	const int32_t index = Find(timer_);
+	if (index >= 0)
+		mRecords[index] = mRecords[--mCount];
+}
+
+uint16_t TimerDirectory::TakeSnapshot(Snapshot* snapshots_, uint16_t capacity_, uint64_t& takenAtMillis_) const
+{
+	const uint64_t nowMillis = millis();
+	takenAtMillis_ = nowMillis;
+
+	const uint16_t count = mCount < capacity_ ? mCount : capacity_;
+	for (uint16_t index = 0; index < count; ++index)
+	{
+		const Record& record = mRecords[index];
+		const Timer& timer = *record.mTimer;
+		//	Only an overdue timer (wrapped to UINT32_MAX) has more left than its interval.
+		const uint32_t leftMillis = timer.IsActive() ? timer.TimeLeftInMillis(nowMillis) : 0;
+		uint8_t flags = 0;
+		if (timer.IsActive())
+			flags |= FLAG_ACTIVE;
+		if (timer.IsOverridden())
+			flags |= FLAG_OVERRIDDEN;
+
+		snapshots_[index] = Snapshot{
+			record.mName,
+			record.mNameHash,
+			timer.GetInterval(),
+			leftMillis <= timer.GetInterval() ? leftMillis : 0,
+			timer.GetReachedCount(),
+			timer.GetMaxOverrunMillis(),
+			flags
+		};
+	}
+	return count;
+}
+
+size_t TimerDirectory::Encode(const Snapshot* snapshots_, uint16_t count_, uint64_t takenAtMillis_,
+								uint8_t* buffer_, size_t size_)
+{
+	size_t used = 0;
+	bool fits = PutByte(buffer_, size_, used, ENCODING_MAGIC[0])
+				&& PutByte(buffer_, size_, used, ENCODING_MAGIC[1])
+				&& PutByte(buffer_, size_, used, ENCODING_VERSION)
+				&& PutVarint(buffer_, size_, used, count_)
+				&& PutVarint(buffer_, size_, used, takenAtMillis_);
+
+	for (uint16_t index = 0; fits && index < count_; ++index)
+	{
+		const Snapshot& snapshot = snapshots_[index];
+		for (uint8_t shift = 0; fits && shift < 32; shift += 8)
+			fits = PutByte(buffer_, size_, used, static_cast<uint8_t>(snapshot.mNameHash >> shift));
+		fits = fits
+				&& PutByte(buffer_, size_, used, snapshot.mFlags)
+				&& PutVarint(buffer_, size_, used, snapshot.mIntervalMillis)
+				&& PutVarint(buffer_, size_, used, snapshot.mTimeLeftMillis)
+				&& PutVarint(buffer_, size_, used, snapshot.mReachedCount)
+				&& PutVarint(buffer_, size_, used, snapshot.mMaxOverrunMillis);
+	}
+	return fits ? used : 0;
+}
+
+uint32_t TimerDirectory::HashName(const __FlashStringHelper* name_)
+{
+	uint32_t hash = FNV_OFFSET_BASIS;
+	if (!name_)
+		return hash;
+
+	const char* name = reinterpret_cast<const char*>(name_);
+	for (uint8_t character = pgm_read_byte(name); character != 0; character = pgm_read_byte(++name))
+	{
+		hash ^= character;
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+int32_t TimerDirectory::Find(const Timer& timer_) const
+{
+	for (uint16_t index = 0; index < mCount; ++index)
+	{
+		if (mRecords[index].mTimer == &timer_)
+			return index;
+	}
+	return -1;
+}
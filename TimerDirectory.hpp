@@ -0,0 +1,137 @@
+/**
+ * 	TimerDirectory class.
+ *
+ * 	Timers are usually anonymous globals. For diagnostics, they can be
+ * 	registered here (opt-in) under a name - a flash string or just a 32 bit
+ * 	hash of it, if the string should not be kept. TakeSnapshot() then
+ * 	captures the state of all registered timers (interval, time left,
+ * 	active / override state and statistics) against a single clock reading.
+ *
+ * 	The snapshot is written into a buffer of the caller: no heap, and the
+ * 	time is bounded by the number of registered timers. Encode() turns it
+ * 	into a compact binary form for export (see there).
+ *
+ * There are a few things to keep in mind:
+ * 		- The directory only keeps pointers. Unregister a timer before it is
+ * 			destroyed (globals usually never are).
+ * 		- Names are hashed with 32 bit FNV-1a, see HashName().
+ * 		- Reached counts and overruns are only recorded with TIMER_STATISTICS
+ * 			(see Timer.hpp); otherwise they are reported as 0.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "Timer.hpp"
+
+class TimerDirectory {
+
+public:
+
+	struct Record {
+		const Timer* mTimer;
+		const __FlashStringHelper* mName;
+		uint32_t mNameHash;
+	};
+
+	//	Snapshot::mFlags bits.
+	static constexpr uint8_t FLAG_ACTIVE = 0x01;
+	static constexpr uint8_t FLAG_OVERRIDDEN = 0x02;
+
+	struct Snapshot {
+		const __FlashStringHelper* mName;
+		uint32_t mNameHash;
+		uint32_t mIntervalMillis;
+		uint32_t mTimeLeftMillis;
+		uint32_t mReachedCount;
+		uint32_t mMaxOverrunMillis;
+		uint8_t mFlags;
+	};
+
+	//	First bytes of an encoded snapshot, followed by the format version.
+	static constexpr uint8_t ENCODING_MAGIC[2] = {'T', 'S'};
+	static constexpr uint8_t ENCODING_VERSION = 1;
+
+	/**
+	 * @brief Creates an empty directory on the passed storage. Prefer StaticTimerDirectory<N>.
+	 */
+	TimerDirectory(Record* records_, uint16_t capacity_);
+
+	/**
+	 * @brief Registers a timer under a name kept in flash (use F("name")).
+	 *
+	 * @return False if the directory is full or the timer is already registered.
+	 */
+	bool Register(const Timer& timer_, const __FlashStringHelper* name_);
+
+	/**
+	 * @brief Registers a timer under a name hash only (see HashName()).
+	 */
+	bool Register(const Timer& timer_, uint32_t nameHash_);
+
+	void Unregister(const Timer& timer_);
+
+	auto GetCount() const -> uint16_t {return mCount;}
+
+	/**
+	 * @brief Captures the state of all registered timers at a single clock reading.
+	 *
+	 * @param snapshots_: Buffer for the records.
+	 * @param capacity_: Number of records the buffer holds; further timers are left out.
+	 * @param takenAtMillis_: Receives the clock reading all records refer to.
+	 * @return The number of records written.
+	 */
+	uint16_t TakeSnapshot(Snapshot* snapshots_, uint16_t capacity_, uint64_t& takenAtMillis_) const;
+
+	/**
+	 * @brief Encodes a snapshot for export:
+	 * 		magic "TS", version, record count (varint), clock reading (varint),
+	 * 		then per record name hash (4 bytes little endian), flags (1 byte)
+	 * 		and interval, time left, reached count, max overrun (varints).
+	 * 		Varints are unsigned LEB128 (7 bits per byte, low bits first).
+	 *
+	 * @return The number of bytes written, 0 if the buffer is too small.
+	 */
+	static size_t Encode(const Snapshot* snapshots_, uint16_t count_, uint64_t takenAtMillis_,
+							uint8_t* buffer_, size_t size_);
+
+	/**
+	 * @brief Returns the 32 bit FNV-1a hash of a name in flash.
+	 */
+	static uint32_t HashName(const __FlashStringHelper* name_);
+
+
+private:
+
+	int32_t Find(const Timer& timer_) const;
+
+	Record* mRecords;
+	uint16_t mCapacity;
+	uint16_t mCount{0};
+
+};
+
+
+/**
+ * 	Storage for StaticTimerDirectory, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct TimerDirectoryStorage {
+	TimerDirectory::Record mRecordStorage[CAPACITY];
+};
+
+/**
+ * 	TimerDirectory with built-in storage for CAPACITY timers.
+ */
+template <uint16_t CAPACITY>
+class StaticTimerDirectory : private TimerDirectoryStorage<CAPACITY>, public TimerDirectory {
+
+public:
+
+	StaticTimerDirectory() :
+		TimerDirectory(this->mRecordStorage, CAPACITY)
+	{
+	}
+
+};
@@ -0,0 +1,99 @@
+#include "TimerForecast.hpp"
+
+TimerForecast::TimerForecast(const TimerRegistry& registry_, uint64_t nowMillis_, uint32_t windowMillis_,
+								Candidate* candidates_, uint16_t candidateCapacity_) :
+	mRegistry(registry_),
+	mCandidates(candidates_),
+	mCandidateCapacity(candidateCapacity_)
+{
+	Restart(nowMillis_, windowMillis_);
+}
+
+void TimerForecast::Restart(uint64_t nowMillis_, uint32_t windowMillis_)
+{
+	mCandidateCount = 0;
+	mTruncated = false;
+	mNowMillis = nowMillis_;
+	mUntilMillis = nowMillis_ + windowMillis_;
+	PushIndexNode(0);
+}
+
+bool TimerForecast::Next(Expiry& expiry_)
+{
+	if (0 == mCandidateCount)
+		return false;
+
+	const Candidate candidate = mCandidates[0];
+	Pop();
+
+	TimerRegistry::Handle handle = candidate.mReference;
+	if (!candidate.mPredicted)
+	{
+		//	First visit of an index node: its children may be due as well.
+		handle = mRegistry.mHeap.NodeAt(candidate.mReference).mId;
+		PushIndexNode(2u * candidate.mReference + 1u);
+		PushIndexNode(2u * candidate.mReference + 2u);
+	}
+
+	const uint32_t period = mRegistry.mEntries[handle].mPeriod;
+	if (period > 0)
+	{
+		const uint64_t repetition = TimerRegistry::NextPeriodicDeadline(candidate.mAtMillis, period, mNowMillis);
+		if (repetition <= mUntilMillis)
+			Push(Candidate{repetition, handle, true});
+	}
+
+	expiry_ = Expiry{handle, candidate.mAtMillis, candidate.mPredicted};
+	return true;
+}
+
+void TimerForecast::PushIndexNode(uint32_t position_)
+{
+	if (position_ >= mRegistry.mHeap.Size())
+		return;
+
+	//	The index is a heap: if this node is outside the window, its subtree is as well.
+	const uint64_t deadline = mRegistry.mHeap.NodeAt(position_).mDeadline;
+	if (deadline <= mUntilMillis)
+		Push(Candidate{deadline, static_cast<uint16_t>(position_), false});
+}
+
+void TimerForecast::Push(const Candidate& candidate_)
+{
+	if (mCandidateCount >= mCandidateCapacity)
+	{
+		mTruncated = true;
+		return;
+	}
+
+	uint16_t position = mCandidateCount++;
+	while (position > 0)
+	{
+		const uint16_t parent = (position - 1) / 2;
+		if (mCandidates[parent].mAtMillis <= candidate_.mAtMillis)
+			break;
+		mCandidates[position] = mCandidates[parent];
+		position = parent;
+	}
+	mCandidates[position] = candidate_;
+}
+
+void TimerForecast::Pop()
+{
+	const Candidate last = mCandidates[--mCandidateCount];
+	uint16_t position = 0;
+	for (;;)
+	{
+		uint32_t child = 2u * position + 1u;
+		if (child >= mCandidateCount)
+			break;
+		if (child + 1u < mCandidateCount && mCandidates[child + 1u].mAtMillis < mCandidates[child].mAtMillis)
+			++child;
+		if (last.mAtMillis <= mCandidates[child].mAtMillis)
+			break;
+		mCandidates[position] = mCandidates[child];
+		position = static_cast<uint16_t>(child);
+	}
+	if (mCandidateCount > 0)
+		mCandidates[position] = last;
+}
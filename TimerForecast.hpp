@@ -0,0 +1,118 @@
+/**
+ * 	TimerForecast class.
+ *
+ * 	Answers "which entries of a TimerRegistry will expire within the next
+ * 	X ms?" - f.e. to batch radio transmissions or to plan flash erases
+ * 	around upcoming work. Expiries are returned one by one in time order
+ * 	by Next(), including the predicted repetitions of periodic entries.
+ *
+ * 	The forecast only reads the registry. It walks the deadline index
+ * 	lazily: a small candidate heap holds the root of the index and, once
+ * 	a node was returned, its two children and (for periodic entries) its
+ * 	next repetition. So k results cost O(k log n), independent of the
+ * 	number of entries behind the window.
+ *
+ * There are a few things to keep in mind:
+ * 		- The registry must not be changed (armed, cancelled, dispatched)
+ * 			while a forecast is iterated. Start a new one afterwards.
+ * 		- Entries that are already overdue are returned first, with their
+ * 			(past) deadline. Their repetitions are predicted the same way
+ * 			Dispatch() would re-arm them.
+ * 		- The candidate storage never needs more than one element per armed
+ * 			entry; StaticTimerForecast<N> with the registry's capacity can
+ * 			never be truncated. With less storage IsTruncated() reports if
+ * 			expiries had to be dropped.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class TimerForecast {
+
+public:
+
+	struct Expiry {
+		TimerRegistry::Handle mHandle;
+		uint64_t mAtMillis;
+		//	True for a repetition of a periodic entry (not yet armed as such).
+		bool mPredicted;
+	};
+
+	struct Candidate {
+		uint64_t mAtMillis;
+		//	Position in the registry's deadline index, or the handle for predictions.
+		uint16_t mReference;
+		bool mPredicted;
+	};
+
+	/**
+	 * @brief Creates a forecast for all expiries up to (and including)
+	 * 		nowMillis_ + windowMillis_. Prefer StaticTimerForecast<N>.
+	 *
+	 * @param candidates_: Storage for the candidate heap.
+	 * @param candidateCapacity_: Number of candidates the storage holds.
+	 */
+	TimerForecast(const TimerRegistry& registry_, uint64_t nowMillis_, uint32_t windowMillis_,
+					Candidate* candidates_, uint16_t candidateCapacity_);
+
+	/**
+	 * @brief Returns the next expiry within the window in time order.
+	 *
+	 * @return False once the window is exhausted.
+	 */
+	bool Next(Expiry& expiry_);
+
+	/**
+	 * @brief Starts over with a new window on the current registry state.
+	 */
+	void Restart(uint64_t nowMillis_, uint32_t windowMillis_);
+
+	/**
+	 * @brief Returns true if candidates had to be dropped for lack of storage.
+	 */
+	auto IsTruncated() const -> bool {return mTruncated;}
+
+
+private:
+
+	void PushIndexNode(uint32_t position_);
+	void Push(const Candidate& candidate_);
+	void Pop();
+
+	const TimerRegistry& mRegistry;
+	Candidate* mCandidates;
+	uint16_t mCandidateCapacity;
+	uint16_t mCandidateCount{0};
+	uint64_t mNowMillis{0};
+	uint64_t mUntilMillis{0};
+	bool mTruncated{false};
+
+};
+
+
+/**
+ * 	Storage for StaticTimerForecast, see TimerRegistryStorage.
+ */
+template <uint16_t CAPACITY>
+struct TimerForecastStorage {
+	TimerForecast::Candidate mCandidateStorage[CAPACITY];
+};
+
+/**
+ * 	TimerForecast with built-in candidate storage. Use the registry's
+ * 	capacity as CAPACITY to rule out truncation.
+ */
+template <uint16_t CAPACITY>
+class StaticTimerForecast : private TimerForecastStorage<CAPACITY>, public TimerForecast {
+
+public:
+
+	StaticTimerForecast(const TimerRegistry& registry_, uint64_t nowMillis_, uint32_t windowMillis_) :
+		TimerForecast(registry_, nowMillis_, windowMillis_, this->mCandidateStorage, CAPACITY)
+	{
+	}
+
+};
@@ -0,0 +1,154 @@
+#include "TimerRegistry.hpp"
+
+#include "Timer.hpp"
+
+TimerRegistry::TimerRegistry(Entry* entries_, DeadlineHeap::Node* nodes_, uint16_t* positions_, uint16_t capacity_) :
+	mEntries(entries_),
+	mHeap(nodes_, positions_, capacity_),
+	mCapacity(capacity_)
+{
+	for (uint16_t handle = 0; handle < mCapacity; ++handle)
+		mEntries[handle] = Entry{};
+}
+
+TimerRegistry::Handle TimerRegistry::Add(Callback callback_, void* context_)
+{
+	for (Handle handle = 0; handle < mCapacity; ++handle)
+	{
+		Entry& entry = mEntries[handle];
+		if (entry.mAllocated)
+			continue;
+
+		entry = Entry{};
+		entry.mCallback = callback_;
+		entry.mContext = context_;
+		entry.mAllocated = true;
+		++mAllocatedCount;
+		return handle;
+	}
+	return INVALID_HANDLE;
+}
+
+void TimerRegistry::Remove(Handle handle_)
+{
+	if (!IsValid(handle_))
+		return;
+
+	mHeap.Remove(handle_);
+	mEntries[handle_] = Entry{};
+	--mAllocatedCount;
+}
+
+void TimerRegistry::ArmAt(Handle handle_, uint64_t deadlineMillis_, uint32_t periodMillis_)
+{
+	if (!IsValid(handle_))
+		return;
+
+	mEntries[handle_].mPeriod = periodMillis_;
+	mHeap.Update(handle_, deadlineMillis_);
+}
+
+void TimerRegistry::ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_)
+{
+	ArmAfter(handle_, delayMillis_, periodMillis_, Now());
+}
+
+void TimerRegistry::ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_, uint64_t nowMillis_)
+{
+	ArmAt(handle_, nowMillis_ + delayMillis_, periodMillis_);
+}
+
+void TimerRegistry::Cancel(Handle handle_)
+{
+	if (IsValid(handle_))
+		mHeap.Remove(handle_);
+}
+
+void TimerRegistry::SetPeriod(Handle handle_, uint32_t periodMillis_)
+{
+	if (IsValid(handle_))
+		mEntries[handle_].mPeriod = periodMillis_;
+}
+
+uint16_t TimerRegistry::Dispatch()
+{
+	return Dispatch(millis());
+}
+
+uint16_t TimerRegistry::Dispatch(uint64_t nowMillis_)
+{
+	//	Bounded, so a callback re-arming itself into the past cannot stall the loop.
+	uint16_t fired = 0;
+	mDispatchMillis = nowMillis_;
+	mDispatching = true;
+	while (fired < mCapacity && !mHeap.IsEmpty() && mHeap.Top().mDeadline <= nowMillis_)
+	{
+		const DeadlineHeap::Node node = mHeap.Top();
+		Entry& entry = mEntries[node.mId];
+
+		if (entry.mPeriod > 0)
+		{
+			const uint64_t next = NextPeriodicDeadline(node.mDeadline, entry.mPeriod, nowMillis_);
+			mStats.mMissedPeriods += NarrowConvertToUint32((next - node.mDeadline) / entry.mPeriod - 1);
+			mHeap.Update(node.mId, next);
+		}
+		else
+			mHeap.Pop();
+
+		const uint32_t latenessMillis = NarrowConvertToUint32(nowMillis_ - node.mDeadline);
+		mStats.mLatenessSumMillis += latenessMillis;
+		if (latenessMillis > mStats.mMaxLatenessMillis)
+			mStats.mMaxLatenessMillis = latenessMillis;
+		uint8_t bucket = 0;
+		while (bucket < LATENESS_BUCKET_COUNT - 1 && latenessMillis > LATENESS_BUCKET_BOUNDS[bucket])
+			++bucket;
+		++mStats.mLatenessBuckets[bucket];
+		++mStats.mFired;
+		++entry.mFireCount;
+
+		++fired;
+		if (entry.mCallback)
+			entry.mCallback(entry.mContext, node.mId);
+	}
+	mDispatching = false;
+	if (fired > 0)
+	{
+		++mStats.mWakeups;
+		mPublishedStats.Write(mStats);
+	}
+	return fired;
+}
+
+void TimerRegistry::ResetStats()
+{
+	mStats = Stats{};
+	mPublishedStats.Write(mStats);
+}
+
+uint64_t TimerRegistry::DeadlineOf(Handle handle_) const
+{
+	return IsArmed(handle_) ? mHeap.DeadlineOf(handle_) : NO_DEADLINE;
+}
+
+uint32_t TimerRegistry::TimeUntilNextDeadline() const
+{
+	return TimeUntilNextDeadline(millis());
+}
+
+uint32_t TimerRegistry::TimeUntilNextDeadline(uint64_t nowMillis_) const
+{
+	const uint64_t next = NextDeadline();
+	if (next <= nowMillis_)
+		return 0;
+	return NarrowConvertToUint32(next - nowMillis_);
+}
+
+uint64_t TimerRegistry::NextPeriodicDeadline(uint64_t deadlineMillis_, uint32_t periodMillis_, uint64_t nowMillis_)
+{
+	const uint64_t next = deadlineMillis_ + periodMillis_;
+	if (next > nowMillis_)
+		return next;
+
+	const uint64_t missedPeriods = (nowMillis_ - deadlineMillis_) / periodMillis_;
+	return deadlineMillis_ + (missedPeriods + 1) * periodMillis_;
+}
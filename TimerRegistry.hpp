@@ -0,0 +1,248 @@
+/**
+ * 	TimerRegistry class.
+ *
+ * 	Where Timer is polled by the code owning it, the registry keeps many
+ * 	deadlines in one place and calls back when they are reached. Every
+ * 	entry is a slot in a fixed table; armed slots are additionally kept in
+ * 	a deadline index (DeadlineHeap), so the next deadline is known in O(1)
+ * 	and arming / cancelling costs O(log n) - no matter how many entries
+ * 	are registered.
+ *
+ * 	Dispatch() has to be called from loop(). It reads the clock once and
+ * 	calls back every entry whose deadline has been reached, in deadline
+ * 	order. Entries without an armed deadline cost nothing.
+ *
+ * There are a few things to keep in mind:
+ * 		- Unlike Timer, periodic entries run at a fixed rate: the next
+ * 			deadline is the previous deadline plus the period, not the
+ * 			observed time plus the period. If one or more periods were
+ * 			missed completely, they are skipped (not fired late in a burst).
+ * 		- Callbacks may arm, cancel or remove any entry, including their own.
+ * 			A periodic entry has already been re-armed when its callback runs.
+ * 		- Storage is passed in by the owner. StaticTimerRegistry<N> bundles
+ * 			the storage for N entries, which is the usual way to create one.
+ * 		- All times are absolute milliseconds on the millis() time line. The
+ * 			overloads taking nowMillis_ allow driving the registry from any
+ * 			other (f.e. virtual) clock.
+ * 		- The registry itself is not thread safe. Its statistics, however,
+ * 			are published through a Seqlock after every Dispatch() that fired,
+ * 			so other tasks / cores can read them with ReadPublishedStats().
+ */
+
+#pragma once
+
+#include <Arduino.h>
+#include <limits>
+
+#include "DeadlineHeap.hpp"
+#include "Seqlock.hpp"
+
+class TimerRegistry {
+
+public:
+
+	using Handle = uint16_t;
+	using Callback = void (*)(void* context_, Handle handle_);
+
+	//	Returned by Add() if the registry is full.
+	static constexpr Handle INVALID_HANDLE = DeadlineHeap::INVALID_ID;
+	//	Returned by NextDeadline() if nothing is armed.
+	static constexpr uint64_t NO_DEADLINE = std::numeric_limits<uint64_t>::max();
+
+	//	Upper bounds (inclusive) of the lateness histogram buckets; a last bucket takes the rest.
+	static constexpr uint32_t LATENESS_BUCKET_BOUNDS[] = {0, 1, 2, 5, 10, 20, 50, 100, 250, 500, 1000};
+	static constexpr uint8_t LATENESS_BUCKET_COUNT = sizeof(LATENESS_BUCKET_BOUNDS) / sizeof(LATENESS_BUCKET_BOUNDS[0]) + 1;
+
+	//	Dispatch() statistics, cumulative since creation / ResetStats().
+	struct Stats {
+		uint32_t mFired{0};
+		//	Dispatch() calls that fired at least one callback, i.e. wakeups with work.
+		uint32_t mWakeups{0};
+		//	Periods of periodic entries skipped because they passed completely.
+		uint32_t mMissedPeriods{0};
+		//	Lateness: clock reading of Dispatch() minus the deadline.
+		uint64_t mLatenessSumMillis{0};
+		uint32_t mMaxLatenessMillis{0};
+		uint32_t mLatenessBuckets[LATENESS_BUCKET_COUNT]{};
+	};
+
+	struct Entry {
+		Callback mCallback{nullptr};
+		void* mContext{nullptr};
+		uint32_t mPeriod{0};
+		uint32_t mFireCount{0};
+		bool mAllocated{false};
+	};
+
+	/**
+	 * @brief Creates an empty registry on the passed storage.
+	 * 		Prefer StaticTimerRegistry<N>, which provides the storage.
+	 */
+	TimerRegistry(Entry* entries_, DeadlineHeap::Node* nodes_, uint16_t* positions_, uint16_t capacity_);
+
+	TimerRegistry(const TimerRegistry&) = delete;
+	TimerRegistry& operator=(const TimerRegistry&) = delete;
+
+
+	/**
+	 * @brief Allocates an (unarmed) entry.
+	 *
+	 * @param callback_: Called with context_ and the handle once the deadline is reached.
+	 * @param context_: Passed through to the callback unchanged.
+	 * @return The handle of the entry, INVALID_HANDLE if the registry is full.
+	 */
+	Handle Add(Callback callback_, void* context_);
+
+	/**
+	 * @brief Cancels and releases the entry. The handle may be reused by Add().
+	 */
+	void Remove(Handle handle_);
+
+	/**
+	 * @brief Arms the entry for an absolute deadline.
+	 *
+	 * @param deadlineMillis_: Point in time (millis() time line) to call back at.
+	 * @param periodMillis_: If not zero, the entry is re-armed after each
+	 * 						expiry at a fixed rate. Zero means one-shot.
+	 */
+	void ArmAt(Handle handle_, uint64_t deadlineMillis_, uint32_t periodMillis_ = 0);
+
+	/**
+	 * @brief Arms the entry for delayMillis_ from now (see Now()). See ArmAt().
+	 */
+	void ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_ = 0);
+	void ArmAfter(Handle handle_, uint32_t delayMillis_, uint32_t periodMillis_, uint64_t nowMillis_);
+
+	/**
+	 * @brief Disarms the entry. It stays allocated and can be armed again.
+	 */
+	void Cancel(Handle handle_);
+
+	/**
+	 * @brief Changes the period of the entry without moving its current
+	 * 		deadline; the new period applies from the next expiry on.
+	 */
+	void SetPeriod(Handle handle_, uint32_t periodMillis_);
+
+	/**
+	 * @brief Calls back all entries whose deadline has been reached, in
+	 * 		deadline order, against a single clock reading.
+	 *
+	 * @return The number of callbacks made.
+	 */
+	uint16_t Dispatch();
+	uint16_t Dispatch(uint64_t nowMillis_);
+
+
+	auto IsValid(Handle handle_) const -> bool {return handle_ < mCapacity && mEntries[handle_].mAllocated;}
+	auto IsArmed(Handle handle_) const -> bool {return handle_ < mCapacity && mHeap.Contains(handle_);}
+
+	/**
+	 * @brief Returns the deadline of an armed entry, NO_DEADLINE otherwise.
+	 */
+	uint64_t DeadlineOf(Handle handle_) const;
+
+	/**
+	 * @brief Returns the period of the entry (zero for one-shot entries).
+	 */
+	auto PeriodOf(Handle handle_) const -> uint32_t {return IsValid(handle_) ? mEntries[handle_].mPeriod : 0;}
+
+	/**
+	 * @brief Returns callback and context of the entry (nullptr if not allocated).
+	 * 		Handles are reused after Remove(); these tell whose entry it is now.
+	 */
+	auto CallbackOf(Handle handle_) const -> Callback {return IsValid(handle_) ? mEntries[handle_].mCallback : nullptr;}
+	auto ContextOf(Handle handle_) const -> void* {return IsValid(handle_) ? mEntries[handle_].mContext : nullptr;}
+
+	/**
+	 * @brief Returns how often the entry was called back since Add().
+	 * 		A single aligned 32 bit word, so not published via the seqlock:
+	 * 		another core reads it untorn, but not consistent with GetStats().
+	 */
+	auto FireCountOf(Handle handle_) const -> uint32_t {return IsValid(handle_) ? mEntries[handle_].mFireCount : 0;}
+
+	/**
+	 * @brief Returns the earliest armed deadline, NO_DEADLINE if nothing is armed.
+	 */
+	auto NextDeadline() const -> uint64_t {return mHeap.IsEmpty() ? NO_DEADLINE : mHeap.Top().mDeadline;}
+
+	/**
+	 * @brief Returns the time left until the earliest armed deadline
+	 * 		(zero if already reached, uint32_t max if nothing is armed).
+	 */
+	uint32_t TimeUntilNextDeadline() const;
+	uint32_t TimeUntilNextDeadline(uint64_t nowMillis_) const;
+
+	/**
+	 * @brief Returns the clock reading of the running Dispatch() when called
+	 * 		from a callback, millis() otherwise. Lets callbacks re-arm relative
+	 * 		to the same point in time the expiry was detected at.
+	 */
+	auto Now() const -> uint64_t {return mDispatching ? mDispatchMillis : millis();}
+
+	/**
+	 * @brief Returns the statistics. Only from the task calling Dispatch().
+	 */
+	auto GetStats() const -> const Stats& {return mStats;}
+	void ResetStats();
+
+	/**
+	 * @brief Copies the statistics as of the last Dispatch() that fired.
+	 * 		Safe from any task / core; lock-free, retries while being published.
+	 *
+	 * @return False if no consistent copy could be taken (writer too busy).
+	 */
+	auto ReadPublishedStats(Stats& stats_) const -> bool {return mPublishedStats.Read(stats_);}
+
+	auto ArmedCount() const -> uint16_t {return mHeap.Size();}
+	auto AllocatedCount() const -> uint16_t {return mAllocatedCount;}
+	auto Capacity() const -> uint16_t {return mCapacity;}
+
+	/**
+	 * @brief Returns the deadline following deadlineMillis_ for a periodic
+	 * 		entry, skipping all periods that already passed by nowMillis_.
+	 */
+	static uint64_t NextPeriodicDeadline(uint64_t deadlineMillis_, uint32_t periodMillis_, uint64_t nowMillis_);
+
+
+private:
+
+	friend class TimerForecast;
+
+	Entry* mEntries;
+	DeadlineHeap mHeap;
+	uint16_t mCapacity;
+	uint16_t mAllocatedCount{0};
+	uint64_t mDispatchMillis{0};
+	bool mDispatching{false};
+	Stats mStats;
+	Seqlock<Stats> mPublishedStats;
+
+};
+
+
+/**
+ * 	Storage for StaticTimerRegistry. Kept in a base class of its own, so it
+ * 	is constructed before the TimerRegistry base initializes it.
+ */
+template <uint16_t CAPACITY>
+struct TimerRegistryStorage {
+	TimerRegistry::Entry mEntryStorage[CAPACITY];
+	DeadlineHeap::Node mNodeStorage[CAPACITY];
+	uint16_t mPositionStorage[CAPACITY];
+};
+
+/**
+ * 	TimerRegistry with built-in storage for CAPACITY entries.
+ */
+template <uint16_t CAPACITY>
+class StaticTimerRegistry : private TimerRegistryStorage<CAPACITY>, public TimerRegistry {
+
+public:
+
+	StaticTimerRegistry() :
+		TimerRegistry(this->mEntryStorage, this->mNodeStorage, this->mPositionStorage, CAPACITY)
+	{
+	}
+
+};
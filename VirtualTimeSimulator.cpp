@@ -0,0 +1,57 @@
+#include "VirtualTimeSimulator.hpp"
+
+VirtualTimeSimulator::VirtualTimeSimulator(TimerRegistry& registry_, const WakeupModel& model_,
+											EnergyAccount* account_, uint64_t startMillis_) :
+	mRegistry(registry_),
+	mModel(model_),
+	mAccount(account_),
+	mNowMillis(startMillis_),
+	mLastWakeupMillis(startMillis_),
+	mNextWakeupMillis(startMillis_)
+{
+}
+
+uint32_t VirtualTimeSimulator::RunUntil(uint64_t endMillis_)
+{
+	uint32_t wakeups = 0;
+	while (mRegistry.NextDeadline() <= endMillis_)
+	{
+		//	Not before the previous wakeup is over, so entries re-armed for Now() cannot stall the clock.
+		const uint64_t deadline = mRegistry.NextDeadline();
+		const uint64_t wakeupMillis = deadline > mNextWakeupMillis ? deadline : mNextWakeupMillis;
+		if (wakeupMillis > endMillis_)
+			break;
+		if (wakeupMillis > mNowMillis)
+			mNowMillis = wakeupMillis;
+
+		//	One bounded Dispatch() per wakeup; what is still due is the next wakeup's.
+		const uint32_t expiries = mRegistry.Dispatch(mNowMillis);
+
+		AccountSleep(mNowMillis);
+		mLastWakeupMillis = mNowMillis;
+		mLastAwakeMicros = mModel.mBaseAwakeMicros + expiries * mModel.mAwakeMicrosPerExpiry;
+		const uint32_t awakeMillis = (mLastAwakeMicros + 999) / 1000;
+		mNextWakeupMillis = mNowMillis + (awakeMillis > 0 ? awakeMillis : 1);
+		if (mAccount)
+			mAccount->RecordWakeup(mLastAwakeMicros, expiries);
+		++wakeups;
+	}
+
+	if (endMillis_ > mNowMillis)
+	{
+		mNowMillis = endMillis_;
+		AccountSleep(mNowMillis);
+		mLastWakeupMillis = mNowMillis;
+		mLastAwakeMicros = 0;
+	}
+	return wakeups;
+}
+
+void VirtualTimeSimulator::AccountSleep(uint64_t nowMillis_)
+{
+	if (!mAccount)
+		return;
+
+	const uint64_t spanMicros = (nowMillis_ - mLastWakeupMillis) * 1000;
+	mAccount->RecordSleep(spanMicros > mLastAwakeMicros ? spanMicros - mLastAwakeMicros : 0);
+}
@@ -0,0 +1,87 @@
+/**
+ * 	VirtualTimeSimulator class.
+ *
+ * 	Runs a TimerRegistry on a virtual clock instead of millis(), as an
+ * 	ideal tickless sleeping backend would: sleep until the next deadline,
+ * 	wake up, dispatch everything due, sleep again. A simulated day takes
+ * 	only as long as the callbacks need, so timer configurations can be
+ * 	compared offline on the host.
+ *
+ * 	Each wakeup is charged a modelled awake time (a fixed part plus a part
+ * 	per expiry) and, optionally, reported to an EnergyAccount together
+ * 	with the sleep in between. The account's estimate then tells what a
+ * 	configuration costs per day.
+ *
+ * There are a few things to keep in mind:
+ * 		- Callbacks have to take the time from the registry (Now(), or the
+ * 			overloads taking nowMillis_), never from millis().
+ * 		- Arm the initial deadlines against Now() of the simulator, f.e.
+ * 			registry.ArmAfter(handle, 100, 100, simulator.Now()).
+ * 		- Every wakeup runs one (bounded) Dispatch(). The next wakeup is
+ * 			not earlier than the modelled awake time (at least 1 ms) later,
+ * 			so entries re-arming themselves for Now() (f.e. ArmAfter(handle, 0)) let
+ * 			the virtual clock move on. The awake time is taken from the sleep
+ * 			that follows.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "EnergyAccount.hpp"
+#include "TimerRegistry.hpp"
+
+class VirtualTimeSimulator {
+
+public:
+
+	struct WakeupModel {
+		//	Time awake per wakeup, independent of the work done.
+		uint32_t mBaseAwakeMicros;
+		//	Additional time awake per expiry (i.e. per callback).
+		uint32_t mAwakeMicrosPerExpiry;
+	};
+
+	/**
+	 * @brief Creates a simulator starting at startMillis_ on the virtual clock.
+	 *
+	 * @param account_: Receives sleeps and wakeups (optional).
+	 */
+	VirtualTimeSimulator(TimerRegistry& registry_, const WakeupModel& model_,
+							EnergyAccount* account_ = nullptr, uint64_t startMillis_ = 0);
+
+	/**
+	 * @brief Returns the virtual clock reading.
+	 */
+	auto Now() const -> uint64_t {return mNowMillis;}
+
+	/**
+	 * @brief Runs until the virtual clock reaches endMillis_: wakes up at
+	 * 		every deadline up to then and sleeps the rest.
+	 *
+	 * @return The number of wakeups.
+	 */
+	uint32_t RunUntil(uint64_t endMillis_);
+
+	/**
+	 * @brief Runs for durationMillis_ from now. See RunUntil().
+	 */
+	auto RunFor(uint64_t durationMillis_) -> uint32_t {return RunUntil(mNowMillis + durationMillis_);}
+
+
+private:
+
+	//	Reports the sleep from the last wakeup until nowMillis_, minus the time awake.
+	void AccountSleep(uint64_t nowMillis_);
+
+	TimerRegistry& mRegistry;
+	WakeupModel mModel;
+	EnergyAccount* mAccount;
+	uint64_t mNowMillis;
+	//	Virtual time of the last wakeup and the time awake charged for it.
+	uint64_t mLastWakeupMillis;
+	//	End of the last wakeup's awake time, the earliest next wakeup.
+	uint64_t mNextWakeupMillis;
+	uint32_t mLastAwakeMicros{0};
+
+};
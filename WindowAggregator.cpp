@@ -0,0 +1,152 @@
+#include "WindowAggregator.hpp"
+
+namespace {
+
+	//	Free function with restrict parameters and branch free updates, so the loop vectorizes.
+	void AccumulateSamples(const float* __restrict values_, float* __restrict min_, float* __restrict max_,
+							float* __restrict sum_, uint32_t* __restrict count_, float* __restrict last_, uint32_t channels_)
+	{
+		for (uint32_t channel = 0; channel < channels_; ++channel)
+		{
+			const float value = values_[channel];
+			min_[channel] = value < min_[channel] ? value : min_[channel];
+			max_[channel] = value > max_[channel] ? value : max_[channel];
+			sum_[channel] += value;
+			count_[channel] += 1;
+			last_[channel] = value;
+		}
+	}
+
+}
+
+WindowAggregator::WindowAggregator(TimerRegistry& registry_, const Storage& storage_, uint16_t channels_, uint8_t panes_,
+									uint32_t hopMillis_, Sink sink_, void* context_) :
+	mRegistry(registry_),
+	mStorage(storage_),
+	mChannels(channels_),
+	mPanes(panes_ > 0 ? panes_ : 1),
+	mHopMillis(hopMillis_ > 0 ? hopMillis_ : 1),
+	mSink(sink_),
+	mContext(context_),
+	mHopHandle(registry_.Add(OnHop, this))
+{
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+		mStorage.mLast[channel] = NAN;
+	for (uint8_t pane = 0; pane < mPanes; ++pane)
+		ClearPane(pane);
+}
+
+WindowAggregator::~WindowAggregator()
+{
+	mRegistry.Remove(mHopHandle);
+}
+
+void WindowAggregator::Start()
+{
+	for (uint8_t pane = 0; pane < mPanes; ++pane)
+		ClearPane(pane);
+	mCurrentPane = 0;
+	mClosedHops = 0;
+
+	const uint64_t nowMillis = mRegistry.Now();
+	const uint64_t boundary = (nowMillis / mHopMillis + 1) * mHopMillis;
+	mRegistry.ArmAt(mHopHandle, boundary, mHopMillis);
+}
+
+void WindowAggregator::Stop()
+{
+	mRegistry.Cancel(mHopHandle);
+}
+
+void WindowAggregator::AddSample(uint16_t channel_, float value_)
+{
+	if (channel_ >= mChannels)
+		return;
+
+	const uint32_t index = static_cast<uint32_t>(mCurrentPane) * mChannels + channel_;
+	if (value_ < mStorage.mPaneMin[index])
+		mStorage.mPaneMin[index] = value_;
+	if (value_ > mStorage.mPaneMax[index])
+		mStorage.mPaneMax[index] = value_;
+	mStorage.mPaneSum[index] += value_;
+	++mStorage.mPaneCount[index];
+	mStorage.mLast[channel_] = value_;
+}
+
+void WindowAggregator::AddSamples(const float* values_)
+{
+	const uint32_t offset = static_cast<uint32_t>(mCurrentPane) * mChannels;
+	AccumulateSamples(values_, mStorage.mPaneMin + offset, mStorage.mPaneMax + offset, mStorage.mPaneSum + offset,
+						mStorage.mPaneCount + offset, mStorage.mLast, mChannels);
+}
+
+void WindowAggregator::OnHop(void* context_, TimerRegistry::Handle)
+{
+	static_cast<WindowAggregator*>(context_)->CloseWindow();
+}
+
+void WindowAggregator::CloseWindow()
+{
+	float* __restrict windowMin = mStorage.mWindowMin;
+	float* __restrict windowMax = mStorage.mWindowMax;
+	float* __restrict windowSum = mStorage.mWindowSum;
+	uint32_t* __restrict windowCount = mStorage.mWindowCount;
+
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+	{
+		windowMin[channel] = INFINITY;
+		windowMax[channel] = -INFINITY;
+		windowSum[channel] = 0.0f;
+		windowCount[channel] = 0;
+	}
+	for (uint8_t pane = 0; pane < mPanes; ++pane)
+	{
+		const uint32_t offset = static_cast<uint32_t>(pane) * mChannels;
+		const float* paneMin = mStorage.mPaneMin + offset;
+		const float* paneMax = mStorage.mPaneMax + offset;
+		const float* paneSum = mStorage.mPaneSum + offset;
+		const uint32_t* paneCount = mStorage.mPaneCount + offset;
+		for (uint16_t channel = 0; channel < mChannels; ++channel)
+		{
+			windowMin[channel] = paneMin[channel] < windowMin[channel] ? paneMin[channel] : windowMin[channel];
+			windowMax[channel] = paneMax[channel] > windowMax[channel] ? paneMax[channel] : windowMax[channel];
+			windowSum[channel] += paneSum[channel];
+			windowCount[channel] += paneCount[channel];
+		}
+	}
+
+	++mClosedHops;
+	const uint64_t endMillis = mRegistry.Now() / mHopMillis * mHopMillis;
+	const uint32_t windowMillis = GetWindowMillis();
+
+	//	The pane of the first hop started at Start(), not on a boundary.
+	const Window window{
+		endMillis > windowMillis ? endMillis - windowMillis : 0,
+		endMillis,
+		mChannels,
+		windowMin,
+		windowMax,
+		windowSum,
+		windowCount,
+		mStorage.mLast,
+		mClosedHops > mPanes
+	};
+	if (mSink)
+		mSink(mContext, window);
+
+	//	The oldest pane leaves the window and becomes the current one.
+	mCurrentPane = static_cast<uint8_t>((mCurrentPane + 1) % mPanes);
+	ClearPane(mCurrentPane);
+}
+
+void WindowAggregator::ClearPane(uint8_t pane_)
+{
+	const uint32_t offset = static_cast<uint32_t>(pane_) * mChannels;
+	for (uint16_t channel = 0; channel < mChannels; ++channel)
+	{
+		mStorage.mPaneMin[offset + channel] = INFINITY;
+		mStorage.mPaneMax[offset + channel] = -INFINITY;
+		mStorage.mPaneSum[offset + channel] = 0.0f;
+		mStorage.mPaneCount[offset + channel] = 0;
+	}
+}
@@ -0,0 +1,168 @@
+/**
+ * 	WindowAggregator class.
+ *
+ * 	Streaming min / max / sum / count / last per channel over time windows,
+ * 	f.e. 1 minute aggregates of 100 Hz signals - without buffering the raw
+ * 	samples. Each sample updates the aggregate of the current pane in O(1).
+ *
+ * 	A window consists of one or more panes of hopMillis_ each:
+ * 		- tumbling windows: one pane, every window starts where the last ended.
+ * 		- hopping windows: n panes; every hopMillis_ a window of n * hopMillis_
+ * 			is closed, overlapping the previous one by n - 1 panes.
+ * 	Windows close on boundaries aligned to the hop size on the millis() time
+ * 	line (f.e. full minutes), driven by a periodic TimerRegistry entry. On
+ * 	closing, the panes are combined and handed to the sink.
+ *
+ * 	All values are kept as struct of arrays, pane by pane with the channels
+ * 	next to each other. AddSamples() updates all channels of the current pane
+ * 	in one straight loop, which the compiler can vectorize.
+ *
+ * There are a few things to keep in mind:
+ * 		- Storage is passed in by the owner. StaticWindowAggregator<C, P>
+ * 			bundles the storage for C channels and P panes.
+ * 		- The first windows after Start() cover less time than a full window;
+ * 			Window::mComplete is false for them.
+ * 		- Channels without samples in a window report a count of 0, min +inf,
+ * 			max -inf and the last value seen before.
+ */
+
+#pragma once
+
+#include <Arduino.h>
+
+#include "TimerRegistry.hpp"
+
+class WindowAggregator {
+
+public:
+
+	struct Window {
+		uint64_t mStartMillis;
+		uint64_t mEndMillis;
+		uint16_t mChannels;
+		const float* mMin;
+		const float* mMax;
+		const float* mSum;
+		const uint32_t* mCount;
+		const float* mLast;
+		bool mComplete;
+
+		auto Mean(uint16_t channel_) const -> float {return mCount[channel_] > 0 ? mSum[channel_] / mCount[channel_] : NAN;}
+	};
+
+	using Sink = void (*)(void* context_, const Window& window_);
+
+	/**
+	 * Storage pointers. Pane arrays hold panes * channels values, the
+	 * others one value per channel.
+	 */
+	struct Storage {
+		float* mPaneMin;
+		float* mPaneMax;
+		float* mPaneSum;
+		uint32_t* mPaneCount;
+		float* mLast;
+		float* mWindowMin;
+		float* mWindowMax;
+		float* mWindowSum;
+		uint32_t* mWindowCount;
+	};
+
+	/**
+	 * @brief Creates a stopped aggregator. Prefer StaticWindowAggregator<C, P>.
+	 *
+	 * @param channels_: Number of channels.
+	 * @param panes_: Panes per window (1 = tumbling windows).
+	 * @param hopMillis_: Pane length, also the interval windows close in.
+	 * @param sink_: Called with each closed window.
+	 * @param context_: Passed through to the sink.
+	 */
+	WindowAggregator(TimerRegistry& registry_, const Storage& storage_, uint16_t channels_, uint8_t panes_,
+						uint32_t hopMillis_, Sink sink_, void* context_);
+	~WindowAggregator();
+
+	WindowAggregator(const WindowAggregator&) = delete;
+	WindowAggregator& operator=(const WindowAggregator&) = delete;
+
+	/**
+	 * @brief Clears all panes and starts closing windows on the next aligned boundary.
+	 */
+	void Start();
+
+	/**
+	 * @brief Stops closing windows. Samples are still aggregated.
+	 */
+	void Stop();
+
+	/**
+	 * @brief Adds one sample to one channel.
+	 */
+	void AddSample(uint16_t channel_, float value_);
+
+	/**
+	 * @brief Adds one sample to every channel (values_ holds one value per channel).
+	 */
+	void AddSamples(const float* values_);
+
+	auto GetChannelCount() const -> uint16_t {return mChannels;}
+	auto GetWindowMillis() const -> uint32_t {return mHopMillis * mPanes;}
+
+
+private:
+
+	static void OnHop(void* context_, TimerRegistry::Handle handle_);
+
+	void CloseWindow();
+	void ClearPane(uint8_t pane_);
+
+	TimerRegistry& mRegistry;
+	Storage mStorage;
+	uint16_t mChannels;
+	uint8_t mPanes;
+	uint32_t mHopMillis;
+	Sink mSink;
+	void* mContext;
+	TimerRegistry::Handle mHopHandle;
+	uint8_t mCurrentPane{0};
+	uint32_t mClosedHops{0};
+
+};
+
+
+/**
+ * 	Storage for StaticWindowAggregator, see TimerRegistryStorage.
+ */
+template <uint16_t CHANNELS, uint8_t PANES>
+struct WindowAggregatorStorage {
+	float mPaneMinStorage[PANES * CHANNELS];
+	float mPaneMaxStorage[PANES * CHANNELS];
+	float mPaneSumStorage[PANES * CHANNELS];
+	uint32_t mPaneCountStorage[PANES * CHANNELS];
+	float mLastStorage[CHANNELS];
+	float mWindowMinStorage[CHANNELS];
+	float mWindowMaxStorage[CHANNELS];
+	float mWindowSumStorage[CHANNELS];
+	uint32_t mWindowCountStorage[CHANNELS];
+
+	auto Pointers() -> WindowAggregator::Storage
+	{
+		return WindowAggregator::Storage{mPaneMinStorage, mPaneMaxStorage, mPaneSumStorage, mPaneCountStorage, mLastStorage,
+											mWindowMinStorage, mWindowMaxStorage, mWindowSumStorage, mWindowCountStorage};
+	}
+};
+
+/**
+ * 	WindowAggregator with built-in storage for CHANNELS channels and
+ * 	windows of PANES panes (PANES = 1: tumbling windows).
+ */
+template <uint16_t CHANNELS, uint8_t PANES = 1>
+class StaticWindowAggregator : private WindowAggregatorStorage<CHANNELS, PANES>, public WindowAggregator {
+
+public:
+
+	StaticWindowAggregator(TimerRegistry& registry_, uint32_t hopMillis_, Sink sink_, void* context_) :
+		WindowAggregator(registry_, this->Pointers(), CHANNELS, PANES, hopMillis_, sink_, context_)
+	{
+	}
+
+};
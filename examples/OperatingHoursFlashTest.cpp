@@ -0,0 +1,327 @@
+/**
+ * 	Host test of OperatingHours on a simulated NOR flash.
+ *
+ * 	The simulated flash behaves like NOR: an erase sets a whole sector to
+ * 	0xFF, a write can only clear bits. Writing over bytes that are not
+ * 	erased is counted as a violation (real NOR would silently AND them).
+ * 	A write can be torn after any byte, as a power loss would do, and
+ * 	reads can be made to fail.
+ *
+ * 	Checked:
+ * 		- NOR semantics: a day of simulated operation (VirtualTimeSimulator)
+ * 			never writes over unerased bytes, and a restart restores the
+ * 			totals of the last checkpoint.
+ * 		- Torn final write: a checkpoint torn after every possible byte
+ * 			(the torn byte half programmed) restores the record before it,
+ * 			unless only the padding behind the CRC was lost.
+ * 		- Wear spread: the erase counts of all sectors differ by at most one.
+ * 		- A failed read in Begin() leaves the totals untouched.
+ *
+ * 	Build and run on the host, with an Arduino compatible host header
+ * 	(millis(), delay()) on the include path:
+ * 		g++ -std=c++17 -I. -I<host Arduino.h> examples/OperatingHoursFlashTest.cpp
+ * 			OperatingHours.cpp TimerRegistry.cpp DeadlineHeap.cpp
+ * 			VirtualTimeSimulator.cpp EnergyAccount.cpp <host Arduino sources>
+ * 	Exits with 0 if all checks pass.
+ */
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <OperatingHours.hpp>
+#include <TimerRegistry.hpp>
+#include <VirtualTimeSimulator.hpp>
+
+namespace {
+
+	constexpr uint32_t SECTOR_SIZE = 256;
+	constexpr uint16_t SECTOR_COUNT = 4;
+	constexpr uint16_t CHANNELS = 3;
+	constexpr uint32_t CHECKPOINT_MILLIS = 60000;
+	//	Sentinel of SimulatedFlash::mTearAfterBytes / mFailReadAfterCalls.
+	constexpr uint32_t NEVER = 0xFFFFFFFFu;
+
+	struct SimulatedFlash {
+		uint8_t mBytes[SECTOR_SIZE * SECTOR_COUNT];
+		uint32_t mErases[SECTOR_COUNT];
+		uint32_t mViolations;
+		//	Bytes still written before the power fails.
+		uint32_t mTearAfterBytes;
+		//	Reads still served before reads fail.
+		uint32_t mFailReadAfterCalls;
+		uint32_t mReads;
+	};
+
+	SimulatedFlash sFlash;
+	uint16_t sFailures = 0;
+
+	void Check(bool condition_, const char* what_)
+	{
+		if (condition_)
+			return;
+		++sFailures;
+		printf("FAILED: %s\n", what_);
+	}
+
+	bool FlashRead(void* context_, uint32_t address_, void* data_, size_t length_)
+	{
+		SimulatedFlash& flash = *static_cast<SimulatedFlash*>(context_);
+		++flash.mReads;
+		if (address_ + length_ > sizeof(flash.mBytes) || 0 == flash.mFailReadAfterCalls)
+			return false;
+		if (NEVER != flash.mFailReadAfterCalls)
+			--flash.mFailReadAfterCalls;
+		memcpy(data_, flash.mBytes + address_, length_);
+		return true;
+	}
+
+	bool FlashWrite(void* context_, uint32_t address_, const void* data_, size_t length_)
+	{
+		SimulatedFlash& flash = *static_cast<SimulatedFlash*>(context_);
+		if (address_ % 8 != 0 || length_ % 8 != 0 || address_ + length_ > sizeof(flash.mBytes))
+		{
+			++flash.mViolations;
+			return false;
+		}
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(data_);
+		for (size_t index = 0; index < length_; ++index)
+		{
+			uint8_t& cell = flash.mBytes[address_ + index];
+			if (0xFF != cell)
+				++flash.mViolations;
+			if (0 == flash.mTearAfterBytes)
+			{
+				//	Power lost while programming this byte: only some of its bits made it.
+				cell &= static_cast<uint8_t>(bytes[index] | 0xF0);
+				return false;
+			}
+			if (NEVER != flash.mTearAfterBytes)
+				--flash.mTearAfterBytes;
+			cell &= bytes[index];
+		}
+		return true;
+	}
+
+	bool FlashErase(void* context_, uint16_t sector_)
+	{
+		SimulatedFlash& flash = *static_cast<SimulatedFlash*>(context_);
+		if (sector_ >= SECTOR_COUNT || 0 == flash.mTearAfterBytes)
+			return false;
+		memset(flash.mBytes + sector_ * SECTOR_SIZE, 0xFF, SECTOR_SIZE);
+		++flash.mErases[sector_];
+		return true;
+	}
+
+	const OperatingHours::Flash FLASH = {SECTOR_SIZE, SECTOR_COUNT, FlashRead, FlashWrite, FlashErase, &sFlash};
+
+	void ResetFlash()
+	{
+		memset(sFlash.mBytes, 0xFF, sizeof(sFlash.mBytes));
+		memset(sFlash.mErases, 0, sizeof(sFlash.mErases));
+		sFlash.mViolations = 0;
+		sFlash.mTearAfterBytes = NEVER;
+		sFlash.mFailReadAfterCalls = NEVER;
+		sFlash.mReads = 0;
+	}
+
+	bool TotalsEqual(const OperatingHours& hours_, const uint64_t (&totals_)[CHANNELS])
+	{
+		for (uint16_t channel = 0; channel < CHANNELS; ++channel)
+		{
+			if (hours_.GetTotalMillis(channel) != totals_[channel])
+				return false;
+		}
+		return true;
+	}
+
+	void TakeTotals(const OperatingHours& hours_, uint64_t (&totals_)[CHANNELS])
+	{
+		for (uint16_t channel = 0; channel < CHANNELS; ++channel)
+			totals_[channel] = hours_.GetTotalMillis(channel);
+	}
+
+	//	Adds a (host clock) span to a channel, so the next checkpoint has something to write.
+	void Touch(OperatingHours& hours_, uint16_t channel_)
+	{
+		hours_.Set(channel_, true);
+		delay(1);
+		hours_.Set(channel_, false);
+	}
+
+	//	Switches the channels on the virtual clock: channel n runs for n + 1 of every 4 minutes.
+	struct Load {
+		OperatingHours* mHours;
+		uint32_t mMinute;
+		bool mStopped;
+	};
+
+	void OnLoad(void* context_, TimerRegistry::Handle)
+	{
+		Load& load = *static_cast<Load*>(context_);
+		for (uint16_t channel = 0; channel < CHANNELS; ++channel)
+			load.mHours->Set(channel, !load.mStopped && load.mMinute % 4 <= channel);
+		++load.mMinute;
+	}
+
+	//	Runs a simulated day, then switches everything off and checkpoints.
+	void TestNorSemantics()
+	{
+		ResetFlash();
+		uint64_t totals[CHANNELS];
+		{
+			StaticTimerRegistry<4> registry;
+			StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+			Check(!hours.Begin(), "blank flash holds no record");
+
+			VirtualTimeSimulator simulator(registry, VirtualTimeSimulator::WakeupModel{0, 0});
+			Load load{&hours, 0, false};
+			const TimerRegistry::Handle handle = registry.Add(OnLoad, &load);
+			registry.ArmAfter(handle, 60000, 60000, simulator.Now());
+			simulator.RunFor(24ull * 3600000);
+			load.mStopped = true;
+			simulator.RunFor(60000);
+
+			Check(hours.Checkpoint(), "final checkpoint is written");
+			TakeTotals(hours, totals);
+			Check(totals[0] > 0 && totals[0] < totals[1] && totals[1] < totals[2], "channels ran for different times");
+			Check(hours.GetStats().mErases > SECTOR_COUNT, "a day wraps the flash area");
+			Check(0 == sFlash.mViolations, "only erased bytes are written");
+		}
+
+		StaticTimerRegistry<4> registry;
+		StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+		Check(hours.Begin(), "record found after restart");
+		Check(TotalsEqual(hours, totals), "restart restores the last checkpoint");
+	}
+
+	//	Tears the next checkpoint after every byte of a record, each time on the intact state.
+	void TestTornWrite()
+	{
+		ResetFlash();
+		uint64_t totals[CHANNELS];
+		uint32_t recordSize;
+		{
+			StaticTimerRegistry<4> registry;
+			StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+			hours.Begin();
+			for (uint16_t round = 0; round < 5; ++round)
+			{
+				Touch(hours, round % CHANNELS);
+				Check(hours.Checkpoint(), "checkpoint before the tear");
+			}
+			TakeTotals(hours, totals);
+			recordSize = hours.GetRecordSize();
+		}
+
+		SimulatedFlash intact = sFlash;
+		for (uint32_t tearAfterBytes = 0; tearAfterBytes < recordSize; ++tearAfterBytes)
+		{
+			sFlash = intact;
+			uint32_t sequence;
+			uint64_t tornTotals[CHANNELS];
+			{
+				StaticTimerRegistry<4> registry;
+				StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+				hours.Begin();
+				sequence = hours.GetStats().mSequence;
+				Touch(hours, 0);
+				TakeTotals(hours, tornTotals);
+				sFlash.mTearAfterBytes = tearAfterBytes;
+				Check(!hours.Checkpoint(), "torn checkpoint reports the failure");
+				sFlash.mTearAfterBytes = NEVER;
+			}
+
+			StaticTimerRegistry<4> registry;
+			StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+			Check(hours.Begin(), "record found after a torn write");
+			//	Torn in the padding behind the CRC: the record is complete.
+			if (tearAfterBytes >= recordSize - sizeof(uint32_t))
+			{
+				Check(TotalsEqual(hours, tornTotals), "record complete up to its CRC is restored");
+				Check(hours.GetStats().mSequence == sequence + 1, "record complete up to its CRC is the newest");
+				continue;
+			}
+			Check(TotalsEqual(hours, totals), "torn write restores the record before it");
+			Check(hours.GetStats().mSequence == sequence, "torn record is not taken as the newest");
+		}
+		Check(0 == sFlash.mViolations, "only erased bytes are written");
+	}
+
+	void TestWearSpread()
+	{
+		ResetFlash();
+		StaticTimerRegistry<4> registry;
+		StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+		hours.Begin();
+		const uint32_t slotsPerSector = SECTOR_SIZE / hours.GetRecordSize();
+		const uint32_t checkpoints = 25 * SECTOR_COUNT * slotsPerSector + slotsPerSector / 2;
+		for (uint32_t round = 0; round < checkpoints; ++round)
+		{
+			Touch(hours, static_cast<uint16_t>(round % CHANNELS));
+			hours.Checkpoint();
+		}
+
+		uint32_t least = NEVER;
+		uint32_t most = 0;
+		uint32_t erases = 0;
+		for (uint16_t sector = 0; sector < SECTOR_COUNT; ++sector)
+		{
+			least = sFlash.mErases[sector] < least ? sFlash.mErases[sector] : least;
+			most = sFlash.mErases[sector] > most ? sFlash.mErases[sector] : most;
+			erases += sFlash.mErases[sector];
+		}
+		printf("wear: %u checkpoints, %u erases, per sector %u..%u\n", checkpoints, erases, least, most);
+		Check(most - least <= 1, "erases are spread over all sectors");
+		Check(erases == hours.GetStats().mErases, "every erase is counted");
+		Check(erases == (checkpoints + slotsPerSector - 1) / slotsPerSector, "one erase per sector of records");
+		Check(0 == sFlash.mViolations, "only erased bytes are written");
+	}
+
+	void TestFailedRead()
+	{
+		ResetFlash();
+		uint64_t totals[CHANNELS];
+		uint32_t beginReads;
+		{
+			StaticTimerRegistry<4> registry;
+			StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+			hours.Begin();
+			Touch(hours, 1);
+			hours.Checkpoint();
+			TakeTotals(hours, totals);
+
+			StaticTimerRegistry<4> otherRegistry;
+			StaticOperatingHours<CHANNELS> other(otherRegistry, FLASH, CHECKPOINT_MILLIS);
+			sFlash.mReads = 0;
+			other.Begin();
+			beginReads = sFlash.mReads;
+		}
+
+		//	The last read of Begin() is the last total of the newest record.
+		StaticTimerRegistry<4> registry;
+		StaticOperatingHours<CHANNELS> hours(registry, FLASH, CHECKPOINT_MILLIS);
+		sFlash.mFailReadAfterCalls = beginReads - 1;
+		Check(!hours.Begin(), "failed read is reported");
+		const uint64_t zero[CHANNELS] = {};
+		Check(TotalsEqual(hours, zero), "failed read leaves the totals untouched");
+		Check(0 == hours.GetStats().mSequence, "failed read leaves the sequence untouched");
+
+		sFlash.mFailReadAfterCalls = NEVER;
+		Check(hours.Begin(), "Begin() can be repeated");
+		Check(TotalsEqual(hours, totals), "repeated Begin() restores the totals");
+	}
+
+}
+
+int main()
+{
+	TestNorSemantics();
+	TestTornWrite();
+	TestWearSpread();
+	TestFailedRead();
+
+	printf("%s (%u failed)\n", 0 == sFailures ? "PASSED" : "FAILED", sFailures);
+	return 0 == sFailures ? 0 : 1;
+}